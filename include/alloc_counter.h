@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+// Counts heap allocations so that allocation-free ticks and frames can be
+// checked. Only compiled in with make COUNT_ALLOCS=1, which defines
+// COUNT_ALLOCATIONS. With glibc every malloc, calloc and realloc is counted,
+// raylib's and operator new's included; elsewhere only operator new and
+// new[] are, so raylib's MemAlloc and image loading go unseen.
+namespace AllocCounter {
+#ifdef COUNT_ALLOCATIONS
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+uint64_t GetCount(); // Always 0 when disabled
+}
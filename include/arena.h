@@ -0,0 +1,133 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+// Linear allocator for temporaries that all die together at the end of a tick
+// or frame. Allocation is a pointer bump and Reset frees everything at once.
+// If a cycle outgrows the buffer the excess is served from the heap, and the
+// next Reset regrows the buffer so that steady-state cycles never allocate.
+class Arena {
+public:
+  explicit Arena(size_t capacity = 64 * 1024);
+  ~Arena();
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  void *Allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+  template <typename T> T *AllocateArray(size_t count) {
+    return static_cast<T *>(Allocate(count * sizeof(T), alignof(T)));
+  }
+  void Reset();
+
+  size_t GetUsed() const { return offset + overflowBytes; }
+  size_t GetCapacity() const { return capacity; }
+  size_t GetHighWater() const { return highWater; }
+
+private:
+  char *buffer;
+  size_t capacity;
+  size_t offset = 0;
+  std::vector<void *> overflow; // Heap blocks handed out since the last Reset
+  size_t overflowBytes = 0;
+  size_t highWater = 0;
+};
+
+// Standard allocator adapter so containers can live in an Arena. Deallocation
+// is a no-op; memory comes back when the arena is reset.
+template <typename T> class ArenaAllocator {
+public:
+  typedef T value_type;
+
+  explicit ArenaAllocator(Arena *arena) : arena(arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  T *allocate(size_t count) { return arena->AllocateArray<T>(count); }
+  void deallocate(T *, size_t) {}
+
+  Arena *arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena != b.arena;
+}
+
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// Free list of equal-sized blocks for node-based containers whose nodes come
+// and go steadily, such as the id index as creatures are born and die. Freed
+// nodes are kept and handed out again, and when none are left the pool takes
+// as many again as it holds in one go, so inserting allocates only as often
+// as a vector growing to the same size would.
+class NodePool {
+public:
+  NodePool() {}
+  ~NodePool();
+  NodePool(const NodePool &) = delete;
+  NodePool &operator=(const NodePool &) = delete;
+
+  // nullptr if the pool serves blocks of another size, set by the first
+  // request
+  void *Take(size_t bytes);
+  // false if the pool serves blocks of another size
+  bool Give(void *block, size_t bytes);
+
+private:
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+  FreeBlock *head = nullptr;
+  size_t blockBytes = 0;
+  size_t blockCount = 0;       // Handed out or free
+  std::vector<char *> batches; // Where the blocks came from
+};
+
+// Standard allocator adapter over a NodePool. Single objects bigger than a
+// pointer, which is what nodes are allocated as, go through the pool; hash
+// buckets, single or in arrays, go to the heap.
+template <typename T> class PoolAllocator {
+public:
+  typedef T value_type;
+
+  explicit PoolAllocator(NodePool *pool) : pool(pool) {}
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U> &other) : pool(other.pool) {}
+
+  T *allocate(size_t count) {
+    void *block = IsNode(count) ? pool->Take(sizeof(T)) : nullptr;
+    return static_cast<T *>(block ? block : ::operator new(count * sizeof(T)));
+  }
+  void deallocate(T *block, size_t count) {
+    if (!IsNode(count) || !pool->Give(block, sizeof(T))) {
+      ::operator delete(block);
+    }
+  }
+  static bool IsNode(size_t count) {
+    return count == 1 && sizeof(T) > sizeof(void *);
+  }
+
+  NodePool *pool;
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T> &a, const PoolAllocator<U> &b) {
+  return a.pool == b.pool;
+}
+
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T> &a, const PoolAllocator<U> &b) {
+  return a.pool != b.pool;
+}
+
+template <typename K, typename V>
+using PooledMap = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>,
+                                     PoolAllocator<std::pair<const K, V>>>;
@@ -0,0 +1,92 @@
+#pragma once
+#include "random_stream.h"
+#include <cstdint>
+#include <vector>
+
+// Fixed topology shared by every brain: the inputs feed one tanh hidden
+// layer, which feeds tanh outputs. Input vectors are scaled to about -1..1.
+namespace BrainLayout {
+enum Input {
+  FOOD_AHEAD, // Nearest perceived food relative to the facing direction
+  FOOD_SIDE,  // (positive to the right), 0 if none
+  CREATURE_AHEAD, // Nearest perceived creature, likewise
+  CREATURE_SIDE,
+  ENERGY,
+  HEALTH,
+  AGE,
+  BIAS, // Always 1
+  INPUT_COUNT,
+};
+enum Output {
+  STEER_AHEAD, // Acceleration relative to the facing direction while free
+  STEER_SIDE,  // to move
+  MATE,  // Willing to mate when positive
+  FIGHT, // Willing to fight when positive
+  OUTPUT_COUNT,
+};
+const int HIDDEN_COUNT = 8;
+// Hidden weights (bias via the BIAS input), then output weights plus a bias
+const int HIDDEN_WEIGHTS = HIDDEN_COUNT * INPUT_COUNT;
+const int WEIGHT_COUNT = HIDDEN_WEIGHTS + OUTPUT_COUNT * (HIDDEN_COUNT + 1);
+} // namespace BrainLayout
+
+struct BrainInput {
+  float values[BrainLayout::INPUT_COUNT];
+};
+
+struct BrainOutput {
+  float values[BrainLayout::OUTPUT_COUNT];
+};
+
+// Heritable brain weights
+struct Genome {
+  float weights[BrainLayout::WEIGHT_COUNT];
+
+  static Genome Random();
+  // Uniform crossover of both parents followed by mutation, drawn from the
+  // mating creature's stream
+  static Genome Inherit(const Genome &a, const Genome &b,
+                        RandomStream &random);
+  // Evaluates this one brain; BrainBatch computes the same thing in bulk
+  BrainOutput Evaluate(const BrainInput &input) const;
+};
+
+// Brains of the whole population, packed LANES creatures to a block with
+// every weight stored lane-contiguous. Evaluation is then a run of lane-wide
+// multiply-adds with no gathers, which the compiler turns into SIMD on
+// whatever vector width the target has. Entries are indexed like
+// World::creatures and follow its swap-and-pop removal. The batch is the only
+// place genomes are kept, so a world without brains stores none.
+class BrainBatch {
+public:
+  static const int LANES = 8;
+
+  void Clear();
+  void Add(const Genome &genome); // Becomes entry GetCount() - 1
+  void Remove(uint32_t index);    // The last entry moves into index
+  // Grows to count entries with zero weights, for Set to fill in. Set only
+  // writes the one entry's lanes, so different entries can be set at once
+  // on different threads.
+  void Resize(uint32_t count);
+  void Set(uint32_t index, const Genome &genome);
+  Genome GetGenome(uint32_t index) const;
+  // Entry i becomes the one that was at order[i], as World::ReorderStorage
+  // moves the creatures
+  void Reorder(const uint32_t *order);
+  uint32_t GetCount() const { return count; }
+
+  void SetInput(uint32_t index, const BrainInput &input);
+  void Evaluate();
+  BrainOutput GetOutput(uint32_t index) const;
+
+private:
+  struct Block {
+    float weights[BrainLayout::WEIGHT_COUNT][LANES];
+    float inputs[BrainLayout::INPUT_COUNT][LANES];
+    float outputs[BrainLayout::OUTPUT_COUNT][LANES];
+  };
+
+  std::vector<Block> blocks;
+  std::vector<Block> reordered; // Scratch space for Reorder
+  uint32_t count = 0;
+};
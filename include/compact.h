@@ -0,0 +1,70 @@
+#pragma once
+#include "raylib.h"
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Storage types for Creature's fields. A normal build uses plain floats. A
+// build with CREATURE_COMPACT (make COMPACT=1) stores fixed-point values
+// that convert on every read and write, so the simulation code is the same
+// in both builds.
+
+// A real number kept as value * SCALE in an integer, rounded to nearest and
+// saturating at the ends of the storage type
+template <typename Storage, int SCALE> class Fixed {
+public:
+  Fixed() = default;
+  Fixed(float value) { *this = value; }
+  Fixed &operator=(float value) {
+    const float low = std::numeric_limits<Storage>::min();
+    const float high = std::numeric_limits<Storage>::max();
+    raw = (Storage)std::fmin(std::fmax(std::round(value * SCALE), low), high);
+    return *this;
+  }
+  operator float() const { return raw * (1.0f / SCALE); }
+  Fixed &operator+=(float value) { return *this = (float)*this + value; }
+  Fixed &operator-=(float value) { return *this = (float)*this - value; }
+  Fixed &operator*=(float value) { return *this = (float)*this * value; }
+
+private:
+  Storage raw;
+};
+
+// Vector2 made of Fixed components, readable wherever a Vector2 is
+template <typename Component> struct FixedVector2 {
+  Component x;
+  Component y;
+
+  FixedVector2() = default;
+  FixedVector2(float x, float y) : x(x), y(y) {}
+  FixedVector2(Vector2 v) : x(v.x), y(v.y) {}
+  operator Vector2() const { return Vector2{x, y}; }
+};
+
+namespace CreatureFields {
+#ifdef CREATURE_COMPACT
+// Positions to 1/16 unit over 0..4096, which covers the world; larger
+// worlds would store them relative to the tile they are in
+typedef FixedVector2<Fixed<uint16_t, 16>> Position;
+typedef FixedVector2<Fixed<int16_t, 1024>> Velocity; // +-32
+typedef Fixed<uint16_t, 500> Strength;               // 40..100
+typedef Fixed<uint16_t, 40000> Rate; // Speed and metabolism, 0.5..1.5
+typedef Fixed<uint16_t, 256> Size;    // 0..256
+// Health and energy to 1/256 over +-128, which covers their starting 100
+// and how far starving or a lost fight takes them below zero
+typedef Fixed<int16_t, 256> Vital;
+// In physics timesteps, so a Step's age adds up exactly; it stops counting
+// after about 18 minutes, well past MATING_AGE
+typedef Fixed<uint16_t, 60> Age;
+typedef uint32_t WheelTick; // Over two years of simulated time
+#else
+typedef Vector2 Position;
+typedef Vector2 Velocity;
+typedef float Strength;
+typedef float Rate;
+typedef float Size;
+typedef float Vital;
+typedef float Age;
+typedef uint64_t WheelTick;
+#endif
+} // namespace CreatureFields
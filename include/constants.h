@@ -1,41 +1,96 @@
 #pragma once
 
+// Values a scenario file (--scenario) can change are variables, defined with
+// their defaults in constants.cpp and set once at startup; the rest are
+// fixed at build time.
 namespace Constants {
 // Creature traits
-constexpr float INITIAL_HEALTH = 100.0f;
-constexpr float INITIAL_ENERGY = 100.0f;
-constexpr float MIN_STRENGTH = 40.0f;
-constexpr float MAX_STRENGTH = 100.0f;
-constexpr float MIN_SPEED = 0.5f;
-constexpr float MAX_SPEED = 1.2f;
-constexpr float MIN_METABOLISM = 0.5f;
-constexpr float MAX_METABOLISM = 1.5f;
+extern float INITIAL_HEALTH;
+extern float INITIAL_ENERGY;
+extern float MIN_STRENGTH;
+extern float MAX_STRENGTH;
+extern float MIN_SPEED;
+extern float MAX_SPEED;
+extern float MIN_METABOLISM;
+extern float MAX_METABOLISM;
 
 // State thresholds
-constexpr float HUNGRY_THRESHOLD = 50.0f;
-constexpr float CRITICAL_HEALTH = 30.0f;
-constexpr float LOW_HEALTH = 70.0f;
-constexpr float MATING_ENERGY = 50.0f;
-constexpr float MATING_AGE = 5.0f;
+extern float HUNGRY_THRESHOLD;
+extern float CRITICAL_HEALTH;
+extern float LOW_HEALTH;
+extern float MATING_ENERGY;
+extern float MATING_AGE;
+
+// State timers (simulation seconds)
+extern float EATING_DURATION;
+extern float MATING_COOLDOWN;
+extern float FIGHT_COOLDOWN;
+extern float SICK_RECOVERY_TIME;
+extern float SICK_RECOVERY_HEALTH;
 
 // Movement
-constexpr float BASE_MOVEMENT_SPEED = 30.0f;
-constexpr float MAX_VELOCITY = 2.0f;
-constexpr float BOUNDARY_BOUNCE = -1.f;
-constexpr float FOOD_SEEK_FORCE = 0.5f;
+extern float BASE_MOVEMENT_SPEED;
+extern float MAX_VELOCITY;
+extern float BOUNDARY_BOUNCE;
+extern float FOOD_SEEK_FORCE;
 
 // Energy & Health
-constexpr float ENERGY_CONSUMPTION_RATE = 10.f;
-constexpr float HEALTH_DECAY_RATE = 20.0f;
-constexpr float FOOD_ENERGY_VALUE = 100.0f;
+extern float ENERGY_CONSUMPTION_RATE;
+extern float HEALTH_DECAY_RATE;
+extern float FOOD_ENERGY_VALUE;
 
 // Simulation
 constexpr float PHYSICS_TIMESTEP = 1.0f / 60.0f;
-constexpr float FOOD_SPAWN_INTERVAL = 1.f;
-constexpr int FOOD_SPAWN_COUNT = 5;
-constexpr int INITIAL_CREATURE_COUNT = 100;
-constexpr float INITIAL_CREATURE_SIZE = 10.0f;
-constexpr float FOOD_GROW_SIZE = 0.5f;
+extern float FOOD_SPAWN_INTERVAL;
+extern int FOOD_SPAWN_COUNT;
+extern int INITIAL_CREATURE_COUNT;
+extern int INITIAL_FOOD_COUNT; // Placed with the founders, if food is items
+extern float INITIAL_CREATURE_SIZE;
+extern float FOOD_GROW_SIZE;
+
+// Food field (--food-field); densities are in units of one food item
+constexpr float FIELD_CELL_SIZE = 10.0f;
+extern float FIELD_CAPACITY;        // Per cell
+extern float FIELD_REGROWTH_RATE;   // Logistic, per second
+extern float FIELD_SEED_RATE;       // Per cell per second, even if bare
+extern float FIELD_DIFFUSION;       // Cells squared per second
+extern float FIELD_UPDATE_INTERVAL; // Seconds between field updates
+extern float FIELD_BITE_RATE;       // Eaten per second
+extern float FIELD_SCENT_RADIUS;    // Gradient sampling distance
+extern float FIELD_FOOD_THRESHOLD;  // Density worth hunting for
+
+// Perception
+extern float PERCEPTION_RANGE;
+extern float PERCEPTION_FOV;     // Degrees, centred on rotation
+extern float TOUCH_RADIUS_SCALE; // Sensed all around within size * this
+
+// Multi-rate updates
+constexpr int ACTIVITY_NEAR_PERIOD = 4; // Steps per update just off screen
+constexpr int ACTIVITY_FAR_PERIOD = 16; // Steps per update everywhere else
+constexpr float ACTIVITY_NEAR_MARGIN = 300.0f; // Width of the ring off screen
+
+// Storage order
+constexpr int REORDER_CHECK_INTERVAL = 30; // Steps between locality checks
+constexpr float REORDER_DISORDER = 0.25f;  // Share out of curve order to sort
+
+// Brains
+extern float BRAIN_STEER_FORCE;
+extern float BRAIN_AGE_SCALE;     // Age that reads as 1
+extern float BRAIN_MUTATION_RATE; // Chance per inherited weight
+extern float BRAIN_MUTATION_SCALE;
+
+// Rewind
+constexpr int REWIND_SEEK_TICKS = 300; // Per [ or ] press, 5s at full speed
+
+// Soak runs (--soak)
+constexpr float SOAK_SAMPLE_INTERVAL = 60.0f; // Simulated seconds
+constexpr float SOAK_WARMUP = 600.0f;         // Simulated seconds not fitted
+constexpr float SOAK_RSS_GROWTH_LIMIT = 8.0f; // MB per simulated hour
+constexpr float SOAK_LATENCY_DRIFT_LIMIT = 0.5f; // p99 rise over its mean
+
+// Statistics
+constexpr int TRAIT_HISTOGRAM_BINS = 16;
+constexpr float MAX_TRACKED_SIZE = 40.0f; // Larger creatures share the top bin
 
 // Screen
 constexpr int SCREEN_WIDTH = 1200;
@@ -1,27 +1,99 @@
 #pragma once
+#include "brain.h"
+#include "compact.h"
 #include "food.h"
+#include "interaction.h"
+#include "random_stream.h"
 #include "raylib.h"
+#include "timer_wheel.h"
+#include "trait_stats.h"
+#include <cstdint>
+#include <string>
 #include <vector>
 
-enum class CreatureState {
+enum class CreatureState : uint8_t {
   WANDERING,
   HUNTING,
   MATING,
   FIGHTING,
   EATING,
   SICK,
+  COUNT,
+};
+
+struct Senses;
+struct SensedObject;
+struct World;
+
+// A creature's timers, kept beside it in World::creatureTimers as its
+// genome is in World::brains
+struct CreatureTimers {
+  uint32_t tokens[(int)TimerKind::COUNT] = {};
+  // Wheel tick, 0 if idle
+  CreatureFields::WheelTick due[(int)TimerKind::COUNT] = {};
 };
 
 class Creature {
 public:
-  Creature(Vector2 pos, float size);
-  void Update(float deltaTime, const std::vector<Creature> &others,
-              std::vector<Food> &foods, std::vector<Creature> &allCreatures );
+  Creature(Vector2 pos, float size); // Traits from the shared generator
+
+  // World::StepReference's own copy of the rules of a tick, in
+  // reference.cpp, kept apart so that the two engines share no rules
+  struct Reference;
+
+  // Tick phases. World::Step runs each one as a batch over the creatures in
+  // the states it applies to.
+  void UpdateVitals(float deltaTime);
+  // Multi-rate updates: a creature that skips a Step banks its time and
+  // spends it all on the next Step it takes part in
+  void Defer(float deltaTime) { deferredTime += deltaTime; }
+  float Resume(float deltaTime);
+  BrainInput Sense(const Senses &senses) const; // Brain mode only
+  // HUNTING and EATING. FIELD is whether food is a field rather than items,
+  // as in World::StepKernel.
+  template <bool FIELD>
+  void UpdateFeeding(World &world, const Senses &senses, float deltaTime);
+  // Fights and matings are only proposed, nearest first; returns how many
+  // of the InteractionStage::MAX_PROPOSALS slots were filled. Without
+  // FIGHTING only matings are. Nothing shared is written, not even the
+  // timers: fellSick says the creature has just turned SICK, and the caller
+  // starts its recovery with StartRecovery.
+  template <bool FIGHTING, bool FIELD>
+  int UpdateState(World &world, const Senses &senses, Interaction *proposals,
+                  bool &fellSick);
+  void StartRecovery(World &world); // The SICK_RECOVERY timer
+  // Returns whether this creature won, for fights, and whether a child was
+  // conceived, for matings. A ghost proposer's side
+  // is left to its own tile, which applies it with TakeOutcome.
+  bool Interact(InteractionKind kind, Creature &partner, World &world);
+  // SICK only. nearby is every creature within reach, nearest first, as
+  // Perception::Near finds them.
+  void SpreadSickness(World &world, const std::vector<SensedObject> &nearby);
+  float GetContagionRadius() const { return size * 2; }
+  void Halt();                       // EATING, FIGHTING and MATING
+  void Wander(RandomStream random, const World &world); // WANDERING and SICK
+  void Move(float deltaTime);        // Every state that moves
+  void UpdateColor();
+
   void Draw(int rank = 0, const std::vector<Creature> &allCreatures =
                               std::vector<Creature>()) const;
   bool IsAlive() const { return health > 0; }
+  CreatureState GetState() const { return state; }
+  uint32_t GetId() const { return id; }
   Vector2 GetPosition() const { return position; }
-  const std::string &GetName() const { return name; }
+#ifdef CREATURE_COMPACT
+  // Derived rather than stored: facing follows the velocity, so a halted
+  // creature faces along +x
+  float GetRotation() const {
+    return atan2f(velocity.y, velocity.x) * RAD2DEG;
+  }
+#else
+  float GetRotation() const { return rotation; }
+#endif
+  // Spelled out when asked for: from the name code, or in compact builds
+  // from the id
+  std::string GetName() const;
+  float GetSize() const { return size; }
   float GetHealth() const { return health; }
   float GetEnergy() const { return energy; }
   void SetSelected(bool select) { selected = select; }
@@ -30,35 +102,99 @@ public:
   float GetStrength() const { return strength; }
   float GetSpeed() const { return speed; }
   float GetMetabolism() const { return metabolism; }
+  TraitSample GetTraits() const {
+    return TraitSample{{strength, speed, metabolism, size}};
+  }
   bool IsMale() const { return isMale; }
-  void Fight(Creature &opponent);
-  float GetFightProbability(const Creature &opponent) const;
+  void OnTimer(const TimerEvent &event, World &world);
+
+  // Domain decomposition. Ids are handed out from a per-tile range so that
+  // they stay unique across processes; running out of one is fatal.
+  static void ReserveIds(uint32_t first, uint32_t limit = 0xFFFFFFFFu) {
+    nextId = first;
+    idLimit = limit;
+  }
+  static uint32_t GetNextId() { return nextId; }
+  // The first of count consecutive ids
+  static uint32_t TakeIds(uint32_t count);
+  // Wire form of everything but the selection and the fight bookkeeping.
+  // The genome is not part of it; World::WriteCreature adds it.
+  void Write(std::vector<uint8_t> &out) const;
+  static bool Read(const uint8_t *&cursor, const uint8_t *end,
+                   Creature &creature);
+  static Creature Blank() { return Creature(); } // For Read to fill in
+  // A founder with its id, name and traits chosen by the caller, for
+  // WorldGen. Touches nothing shared, so any number can be built at once on
+  // different threads. nameCode comes from Names::Reserve; compact builds
+  // name creatures by id instead.
+  static Creature Founder(uint32_t id, uint64_t nameCode, Vector2 pos,
+                          float size, bool isMale, float strength, float speed,
+                          float metabolism);
+  // A ghost is a halo copy of a creature another tile owns: it is sensed and
+  // interacted with, but never updated here
+  bool IsGhost() const { return ghost; }
+  void MakeGhost() { ghost = true; }
+  // Schedules the timers that were pending when the creature was written,
+  // once it has its place in World::creatures
+  void Rearm(World &world);
+  // Settled claims from DomainNode: the food this creature claimed was
+  // granted, its interaction with another tile's creature went ahead, or a
+  // sick creature there infected it
+  void Eat(World &world);
+  void TakeOutcome(InteractionKind kind, bool won, World &world);
+  void Infect(World &world);
+  // With a little luck drawn from this creature's stream for the opponent
+  float GetFightProbability(const Creature &opponent,
+                            const World &world) const;
 
 private:
-  Creature *lastFightOpponent = nullptr;
-  float timeSinceLastFight = 0.0f;
-  Vector2 position;
-  Vector2 velocity;
+  static uint32_t nextId;
+  static uint32_t idLimit; // One past the last id of the range
+
+  uint32_t id;
+  bool canMate = true;
+  bool canFight = true;
+  float deferredTime = 0.0f;
+  CreatureFields::Position position;
+  CreatureFields::Velocity velocity;
+#ifndef CREATURE_COMPACT
   float rotation; // Facing direction in degrees
-  float size;     // Affects strength and visibility
-  float health;
-  float energy;
-  float age;
+#endif
+  CreatureFields::Size size; // Affects strength and visibility
+  CreatureFields::Vital health;
+  CreatureFields::Vital energy;
+  CreatureFields::Age age;
   CreatureState state;
-  Color color;
+#ifndef CREATURE_COMPACT
+  Color color; // Of the state as of the last UpdateColor
+#endif
 
   // Traits
-  std::string name; // Creature's unique name
+#ifndef CREATURE_COMPACT
+  uint64_t nameCode; // Of the creature's unique name; see Names::Spell
+#endif
   bool isMale;
-  float strength;   // Affects fighting success (0-100)
-  float speed;      // Affects movement speed (0.5-1.5)
-  float metabolism; // Affects energy consumption rate (0.5-1.5)
+  CreatureFields::Strength strength; // Affects fighting success (0-100)
+  CreatureFields::Rate speed;        // Affects movement speed (0.5-1.5)
+  CreatureFields::Rate metabolism; // Affects energy consumption rate (0.5-1.5)
   bool selected = false;
+  bool ghost = false;
 
-  void UpdateState(const std::vector<Creature> &others,
-                   std::vector<Food> &foods,
-                   std::vector<Creature> &allCreatures);
-  void UpdateMovement(float deltaTime, const std::vector<Creature> &others);
-  void UpdateColor();
+  Creature() = default;
+  Creature(Vector2 pos, float size, bool isMale); // Traits left to set
+  uint32_t IndexIn(const World &world) const; // Its place in creatures
+  CreatureTimers &TimersIn(World &world) const;
+  // Brain mode: this Step's brain outputs, which steer the creature and gate
+  // mating and fighting. Otherwise nullptr, and the built-in rules decide.
+  const BrainOutput *ThoughtsIn(const World &world) const;
+  bool Wants(BrainLayout::Output intent, const World &world) const {
+    const BrainOutput *thoughts = ThoughtsIn(world);
+    return !thoughts || thoughts->values[intent] > 0.0f;
+  }
+  void Steer(const BrainOutput &thoughts);
+  // UpdateFeeding when food is a field
+  void Graze(World &world, const Senses &senses, float deltaTime);
+  void StartTimer(TimerKind kind, float seconds, World &world);
+  void TakeFightResult(bool won);
   Color GetStateColor() const;
 };
@@ -0,0 +1,51 @@
+#pragma once
+#include "raylib.h"
+#include <cstdint>
+#include <string>
+
+struct World;
+
+// What a Differential run simulates, and how far apart the engines may be.
+// Creatures draw their random numbers from streams keyed by id and tick, so
+// the engines see the same ones and agree bit for bit. The tolerances are
+// for studying a change that only rounds differently.
+struct DifferentialConfig {
+  unsigned seed = 1;
+  int creatureCount = 300;
+  bool brains = false;
+  bool foodField = false;
+  bool contagion = true;
+  bool fighting = true;
+  // Multi-rate updates, with the focus region a viewport on the middle of
+  // the screen would give
+  bool multiRate = false;
+  Rectangle focusRegion = {400, 250, 400, 300};
+  uint64_t ticks = 3600;
+  float positionTolerance = 0.0f; // World units
+  float vitalsTolerance = 0.0f;   // Health and energy
+  float traitTolerance = 0.0f;    // Strength, speed, metabolism and size
+};
+
+// Holds World::Step to World::StepReference. Both engines start from the
+// same world and run free side by side, on the same seed and ids each tick,
+// and after every tick their creatures are compared by id. Any creature
+// that differs, or is missing from one side, fails the run on the tick it
+// happens.
+class Differential {
+public:
+  explicit Differential(const DifferentialConfig &config) : config(config) {}
+
+  bool Run(); // Whether the engines agreed on every tick
+  uint64_t GetTicksCompared() const { return ticksCompared; }
+  // The first divergence: the tick, then only the creatures and fields that
+  // differ
+  const std::string &GetReport() const { return report; }
+
+private:
+  DifferentialConfig config;
+  uint64_t ticksCompared = 0;
+  std::string report;
+
+  void Tick(World &world, bool reference); // Food spawning, then one Step
+  bool Compare(const World &reference, const World &stepped);
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include "raylib.h"
+#include "world.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// The world cut into a grid of equal tiles, numbered row by row
+struct TileLayout {
+  int columns = 1;
+  int rows = 1;
+  float worldWidth = 0.0f;
+  float worldHeight = 0.0f;
+
+  int GetCount() const { return columns * rows; }
+  int TileAt(Vector2 position) const; // Positions outside count as the edge
+  Rectangle GetBounds(int tile) const;
+  std::vector<int> GetNeighbours(int tile) const; // Up to 8, ascending
+};
+
+// Carries one message per neighbour and Step between tile processes.
+// Exchange sends outgoing[i] to the i-th neighbour and fills incoming[i]
+// with what that neighbour sent in the same round, which keeps neighbouring
+// tiles in lockstep. Returns false once a neighbour has gone away.
+class Transport {
+public:
+  virtual ~Transport() {}
+  virtual bool Exchange(const std::vector<std::vector<uint8_t>> &outgoing,
+                        std::vector<std::vector<uint8_t>> &incoming) = 0;
+};
+
+// Transport over connected Unix-domain stream sockets, for running every
+// tile on one machine. Each message is a u32 length and the payload.
+class SocketTransport : public Transport {
+public:
+  // Socket pairs for every pair of neighbouring tiles, made before the tile
+  // processes fork: links[a][b] is tile a's end of its link to tile b, -1
+  // between tiles that are not neighbours
+  static std::vector<std::vector<int>> Connect(const TileLayout &layout);
+
+  // Takes ownership of the sockets, ordered like the tile's neighbours
+  explicit SocketTransport(const std::vector<int> &sockets);
+  ~SocketTransport();
+  SocketTransport(const SocketTransport &) = delete;
+  SocketTransport &operator=(const SocketTransport &) = delete;
+
+  bool Exchange(const std::vector<std::vector<uint8_t>> &outgoing,
+                std::vector<std::vector<uint8_t>> &incoming) override;
+
+private:
+  std::vector<int> sockets;
+};
+
+// One tile of a decomposed world, driving the tile's own World. A Step
+//   1. sends every neighbour the creatures that left for it, plus ghosts of
+//      everything local within perception range of it,
+//   2. adds the same from every neighbour,
+//   3. steps the World, in which ghosts are sensed like local creatures but
+//      never updated. Whatever the World would do to a ghost or ghost food
+//      is settled with its owner in three more rounds from inside the
+//      Step, as a ClaimExchange: food claims and the claimants that won
+//      them after feeding, fight and mating claims after matching, and
+//      their outcomes and infections after contagion,
+//   4. drops the ghosts and releases creatures that moved off the tile.
+// The halo is as wide as the perception range, so every creature perceives
+// and can interact with exactly what it would in a single-process world,
+// and the owner of anything contested decides it before the Step goes on.
+// Two differences remain: local eaters take food before claims from other
+// tiles, and a creature whose claim is turned down does nothing else in
+// that Step, where a single world would have let it try the next nearest.
+class DomainNode : public ClaimExchange {
+public:
+  DomainNode(const TileLayout &layout, int tile, Transport &transport,
+             World &world);
+  bool Step(float deltaTime); // False once a neighbour has gone away
+  bool Owns(Vector2 position) const {
+    return layout.TileAt(position) == tile;
+  }
+  const std::vector<int> &GetNeighbours() const { return neighbours; }
+
+  void SettleFood(World &) override;
+  void SettleClaims(World &) override;
+  void SettleOutcomes(World &) override;
+
+private:
+  // Everything queued for one neighbour's next message
+  struct Outbox {
+    std::vector<uint8_t> migrants;
+    uint32_t migrantCount = 0;
+    std::vector<FoodClaim> foodClaims;
+    std::vector<uint32_t> fed; // Claimants granted the food
+    std::vector<InteractionClaim> claims;
+    std::vector<InteractionOutcome> outcomes;
+    std::vector<uint32_t> infections;
+  };
+
+  TileLayout layout;
+  int tile;
+  Transport &transport;
+  World &world;
+  std::vector<int> neighbours;
+  std::vector<Rectangle> halos; // Each neighbour grown by perception range
+  std::vector<Outbox> outboxes;
+  std::unordered_map<uint32_t, int> ghostOwners; // Neighbour, by ghost id
+  bool connected = true; // Until an exchange during the Step fails
+  std::vector<std::vector<uint8_t>> outgoing;
+  std::vector<std::vector<uint8_t>> incoming;
+
+  int NeighbourToward(int target) const;
+  void Encode(int neighbour, std::vector<uint8_t> &out);
+  bool Decode(int neighbour, const std::vector<uint8_t> &message);
+  bool Trade(); // Exchanges outgoing for incoming unless already cut off
+  void ReleaseMigrants();
+};
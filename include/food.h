@@ -8,6 +8,9 @@ public:
   bool IsConsumed() const { return consumed; }
   Vector2 GetPosition() const { return position; }
   void Consume() { consumed = true; }
+  // Halo copy of food owned by a neighbouring tile; see DomainNode
+  bool IsGhost() const { return ghost; }
+  void MakeGhost() { ghost = true; }
 
 public:
   static constexpr float SIZE = 6.0f;
@@ -15,4 +18,5 @@ public:
 private:
   Vector2 position;
   bool consumed;
+  bool ghost = false;
 };
@@ -0,0 +1,49 @@
+#pragma once
+#include "raylib.h"
+#include <cstdint>
+#include <vector>
+
+// Food as a density on a grid instead of discrete items, for worlds too
+// large to fill with Food objects. Every FIELD_UPDATE_INTERVAL the field
+// regrows logistically towards FIELD_CAPACITY and diffuses into
+// neighbouring cells in one vectorised stencil pass. Creatures eat from the
+// cell under them and hunt up the gradient. Disabled until Reset is called.
+class FoodField {
+public:
+  FoodField() = default;
+  ~FoodField();
+  FoodField(const FoodField &) = delete;
+  FoodField &operator=(const FoodField &) = delete;
+
+  // Covers width x height world units, starting patchy
+  void Reset(float width, float height);
+  bool IsEnabled() const { return columns > 0; }
+  void Advance(float deltaTime); // Every Step; updates on its own cadence
+
+  float Sample(Vector2 position) const; // Bilinear, 0 outside
+  Vector2 GetGradient(Vector2 position) const; // Per world unit, uphill
+  float Eat(Vector2 position, float amount); // Returns what it got
+  double GetTotal() const;
+
+  // One texture, refreshed only when the field has changed since the last
+  // Draw
+  void Draw() const;
+
+  void Write(std::vector<uint8_t> &out) const;
+  bool Read(const uint8_t *&cursor, const uint8_t *end);
+
+private:
+  int columns = 0;
+  int rows = 0;
+  float pendingTime = 0.0f; // Simulated seconds since the last update
+  std::vector<float> density; // Row-major, columns x rows
+  std::vector<float> scratch;
+  uint64_t version = 0;       // Bumped on every change
+
+  mutable Texture2D texture = {};
+  mutable uint64_t textureVersion = ~0ull;
+  mutable std::vector<uint8_t> pixels; // Gray and alpha per cell
+
+  void Update(float deltaTime);
+  float At(int x, int y) const;
+};
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class Arena;
+struct World;
+
+enum class InteractionKind {
+  FIGHT_OVER_FOOD, // A hungry creature robbing one that is eating
+  FIGHT_OVER_MATE, // A female fighting off an unwanted male
+  MATE,
+  COUNT,
+};
+
+// Something a creature would like to do with a creature it senses
+struct Interaction {
+  InteractionKind kind;
+  uint32_t partner; // Index into World::creatures
+  float distance;
+};
+
+// A proposal to a ghost, which only the ghost's owning tile may accept
+struct InteractionClaim {
+  uint32_t proposerId;
+  uint32_t partnerId;
+  InteractionKind kind;
+  float distance;
+};
+
+// What came of an accepted claim, for the proposer's own tile to apply
+struct InteractionOutcome {
+  uint32_t proposerId;
+  InteractionKind kind;
+  bool won; // Fights only
+};
+
+// Interaction stage. During the decision phase each creature only proposes
+// fights and matings with what it senses, nearest first, into its own slots.
+// Match then picks a matching in which every creature takes part in at most
+// one interaction per tick, closest pairs first with ties broken on ids, and
+// Apply applies the outcomes in that order. Neither the choice nor the
+// outcomes depend on where creatures sit in storage.
+//
+// In a tiled world a proposal to a ghost is only a claim: Match reserves
+// both ends and lists it, the ghost's owner decides with Accept, and the
+// proposer's tile applies the outcome the owner sends back. Apply applies
+// the claims Accept takes along with the local pairs and lists their
+// outcomes for the proposers' tiles.
+class InteractionStage {
+public:
+  static const int MAX_PROPOSALS = 3; // Per creature per tick
+
+  // Slots for this tick's creatures, allocated from the tick arena
+  void Begin(uint32_t creatureCount, Arena &arena);
+  Interaction *GetSlots(uint32_t index) {
+    return proposals + index * MAX_PROPOSALS;
+  }
+  void SetCount(uint32_t index, int count) { counts[index] = (uint8_t)count; }
+  // Creature index turned SICK while deciding; Apply starts its recovery
+  // timer, as the decision phase leaves the timer wheel alone
+  void QueueRecovery(uint32_t index) { recovering[index] = true; }
+  void Match(World &world);
+  const std::vector<InteractionClaim> &GetClaims() const { return claims; }
+  // Claims from other tiles on local creatures, after Match. Taken in the
+  // order Match sorts pairs, each while its partner is still free or is
+  // itself claiming the proposer and loses the tie on ids as in Match.
+  void Accept(World &world, const std::vector<InteractionClaim> &incoming);
+  void Apply(World &world);
+  const std::vector<InteractionOutcome> &GetOutcomes() const {
+    return outcomes;
+  }
+  uint32_t GetMatchedCount() const { return matched; } // In the last Apply
+
+private:
+  // A proposal with both ends' ids, for ordering
+  struct Candidate {
+    float distance;
+    uint32_t lowId;
+    uint32_t highId;
+    uint32_t proposerId;
+    uint32_t proposer; // Indices into World::creatures
+    uint32_t partner;
+    InteractionKind kind;
+  };
+
+  Interaction *proposals = nullptr;
+  uint8_t *counts = nullptr;
+  bool *recovering = nullptr;
+  uint32_t creatureCount = 0;
+  uint32_t matched = 0;
+  bool *busy = nullptr; // Matched or reserved, by index; tick arena
+  // Reused from tick to tick
+  std::vector<Candidate> pairs; // To apply
+  std::vector<InteractionClaim> claims;
+  std::vector<InteractionOutcome> outcomes;
+
+  static bool Before(const Candidate &x, const Candidate &y);
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include "arena.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Genealogy of every creature that is alive or has living descendants.
+// Nodes live in a single arena with a free list; a node is reference counted
+// by "am I alive" plus "how many retained children do I have", so a lineage is
+// released the moment its last living descendant dies.
+class Lineage {
+public:
+  static const uint32_t NONE = 0xFFFFFFFFu;
+
+  // Where a creature sits in the tree, for a tile it moves to
+  struct Placement {
+    uint32_t parents[2]; // Ids, NONE where this tree has none
+    int generation;      // -1 if not tracked
+    bool founder;
+  };
+
+  void AddFounder(uint32_t id);
+  void Reserve(size_t count); // Room for count more creatures
+  void AddBirth(uint32_t id, uint32_t parentA, uint32_t parentB);
+  void RecordDeath(uint32_t id);
+  // Tiled runs. A creature that moves to another tile leaves this tile's
+  // tree without dying, and joins the new one under whichever of its
+  // parents live there, keeping its generation (if not -1). It is a founder
+  // only if it was one.
+  void Depart(uint32_t id);
+  Placement GetPlacement(uint32_t id) const; // Before it departs
+  void AddMigrant(uint32_t id, const Placement &placement);
+  void Clear();
+  // Saves and restores the whole arena, so that later births and deaths
+  // reuse the same slots
+  void Write(std::vector<uint8_t> &out) const;
+  bool Read(const uint8_t *&cursor, const uint8_t *end);
+
+  bool Contains(uint32_t id) const;
+  int GetGeneration(uint32_t id) const; // -1 if not tracked
+  std::vector<uint32_t> GetAncestors(uint32_t id, int maxDepth = -1) const;
+  std::vector<uint32_t> GetDescendants(uint32_t id,
+                                       bool livingOnly = false) const;
+  std::vector<uint32_t> GetSurvivingFounders() const;
+  int GetSurvivingFounderCount() const { return founderCount; }
+
+  size_t GetNodeCount() const { return nodes.size() - freeSlots.size(); }
+  size_t GetArenaCapacity() const { return nodes.capacity(); }
+
+private:
+  // Child lists are intrusive and doubly linked. A child hangs off each of its
+  // two parents, so a link names both the node slot and which parent edge
+  // (slot * 2 + edge) it belongs to.
+  struct Node {
+    uint32_t id;
+    uint32_t parents[2]; // arena slots, NONE for founders
+    uint32_t nextSibling[2];
+    uint32_t prevSibling[2];
+    uint32_t firstChild;
+    uint32_t refs;
+    uint32_t generation;
+    bool alive;
+    bool founder; // Parents are NONE for migrants whose own are elsewhere
+  };
+
+  std::vector<Node> nodes;
+  std::vector<uint32_t> freeSlots;
+  NodePool slotNodes; // Recycles slotById's nodes
+  PooledMap<uint32_t, uint32_t> slotById{
+      PoolAllocator<std::pair<const uint32_t, uint32_t>>(&slotNodes)};
+  int founderCount = 0;
+  std::vector<uint32_t> releaseStack; // Reused so deaths do not allocate
+
+  uint32_t Allocate(uint32_t id);
+  uint32_t FindSlot(uint32_t id) const;
+  void LinkParents(uint32_t slot, uint32_t parentA, uint32_t parentB);
+  void LinkChild(uint32_t parent, uint32_t child, int edge);
+  void UnlinkChild(uint32_t child, int edge);
+  void Release(uint32_t slot);
+};
@@ -1,7 +1,7 @@
 #pragma once
-#include <cstdlib>
+#include <algorithm>
+#include <cstdint>
 #include <string>
-#include <unordered_set>
 #include <vector>
 
 namespace Names {
@@ -41,16 +41,165 @@ const std::vector<std::string> last_names = {
     "hypernova",  "neutrino",    "radiant",    "graviton",  "chronos",
     "helios",     "orionis",     "eonflux",    "singulon",  "exoplanet"};
 
-inline std::string generate_name() {
-  static std::unordered_set<std::string> used_names;
+// Names are numbered round * Combinations() + first * last_names.size() +
+// last, where the round counts how often every combination has been used up
+inline size_t Combinations() { return first_names.size() * last_names.size(); }
 
-  std::string name;
+inline std::string Spell(uint64_t code) {
+  const uint64_t pick = code % Combinations();
+  const uint64_t round = code / Combinations();
+  std::string name = first_names[pick / last_names.size()] + " " +
+                     last_names[pick % last_names.size()];
+  if (round > 0) {
+    name += " " + std::to_string(round + 1);
+  }
+  return name;
+}
+
+// Which names have been handed out, one bit per code; it only grows
+struct Registry {
+  std::vector<bool> taken;
+  std::vector<uint32_t> roundCounts; // Names taken from each round
+  size_t count = 0;
+  size_t round = 0; // The first round with names left
+  // NextCode draws from a generator of its own, so that retries on
+  // taken names do not shift the simulation's random sequence, and logs
+  // what it hands out so that Restore can take the names back
+  uint32_t engine = 1; // Park-Miller minimal standard, never 0
+  std::vector<uint64_t> handedOut;
+};
+
+// How far NextCode had got, saved with the World so that replays from
+// a restored World name their children as the first time round
+struct Mark {
+  uint64_t handedOut;
+  uint32_t engine;
+};
+
+inline Registry &GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+inline size_t UsedCount() { return GetRegistry().count; }
+
+inline void Take(uint64_t code) {
+  Registry &registry = GetRegistry();
+  const size_t round = code / Combinations();
+  if (round >= registry.roundCounts.size()) {
+    registry.roundCounts.resize(round + 1, 0);
+    registry.taken.resize((round + 1) * Combinations(), false);
+  }
+  registry.taken[code] = true;
+  registry.roundCounts[round]++;
+  registry.count++;
+}
+
+inline uint32_t NextRandom(Registry &registry) {
+  registry.engine = (uint32_t)((uint64_t)registry.engine * 48271 % 2147483647);
+  return registry.engine;
+}
+
+// Picks an unused name at random and returns its code, for Spell
+inline uint64_t NextCode() {
+  Registry &registry = GetRegistry();
+
+  // Once every combination is taken, start again with a numeral appended
+  const size_t combinations = Combinations();
+  while (registry.round < registry.roundCounts.size() &&
+         registry.roundCounts[registry.round] == combinations) {
+    registry.round++;
+  }
+
+  uint64_t code;
   do {
-    name = first_names[rand() % first_names.size()] + " " +
-           last_names[rand() % last_names.size()];
-  } while (used_names.find(name) != used_names.end());
+    const size_t first = NextRandom(registry) % first_names.size();
+    const size_t last = NextRandom(registry) % last_names.size();
+    code = registry.round * combinations + first * last_names.size() + last;
+  } while (code < registry.taken.size() && registry.taken[code]);
+  Take(code);
+  registry.handedOut.push_back(code);
+  return code;
+}
 
-  used_names.insert(name);
-  return name;
+inline Mark GetMark() {
+  const Registry &registry = GetRegistry();
+  return Mark{registry.handedOut.size(), registry.engine};
+}
+
+// Takes back every name NextCode handed out since the mark and puts
+// its generator back where it was
+inline void Restore(const Mark &mark) {
+  Registry &registry = GetRegistry();
+  while (registry.handedOut.size() > mark.handedOut) {
+    const uint64_t code = registry.handedOut.back();
+    const size_t round = code / Combinations();
+    registry.handedOut.pop_back();
+    registry.taken[code] = false;
+    registry.roundCounts[round]--;
+    registry.count--;
+    registry.round = std::min(registry.round, round);
+  }
+  registry.engine = mark.engine;
+}
+
+// Spreads consecutive indices over the combinations of their round
+// one-to-one, because the multiplier is a prime that does not divide their
+// count
+inline uint64_t Scatter(uint64_t index) {
+  const uint64_t combinations = Combinations();
+  return index / combinations * combinations +
+         index * 2654435761u % combinations;
+}
+
+// Names taken all at once for bulk world generation: name i of them is
+// Spell(Code(i))
+struct Reservation {
+  std::vector<uint64_t> reused; // Left free in rounds already begun
+  uint64_t first = 0;           // Of the fresh rounds after those
+  uint64_t Code(size_t i) const {
+    return i < reused.size() ? reused[i] : first + Scatter(i - reused.size());
+  }
+};
+
+// Takes count names, first those still free in the rounds NextCode has
+// begun, so bulk generation does not open a new round while one has room,
+// then from rounds untouched so far
+inline Reservation Reserve(size_t count) {
+  Registry &registry = GetRegistry();
+  const size_t combinations = Combinations();
+  Reservation reservation;
+  for (size_t round = registry.round; round < registry.roundCounts.size();
+       round++) {
+    const uint64_t base = (uint64_t)round * combinations;
+    for (size_t i = 0; i < combinations && reservation.reused.size() < count &&
+                       registry.roundCounts[round] < combinations;
+         i++) {
+      const uint64_t code = base + Scatter(i);
+      if (!registry.taken[code]) {
+        Take(code);
+        reservation.reused.push_back(code);
+      }
+    }
+  }
+
+  const size_t fresh = count - reservation.reused.size();
+  const size_t firstRound = registry.roundCounts.size();
+  const size_t rounds = (fresh + combinations - 1) / combinations;
+  reservation.first = (uint64_t)firstRound * combinations;
+  registry.taken.resize((firstRound + rounds) * combinations, false);
+  for (size_t i = 0; i < fresh; i++) {
+    registry.taken[reservation.first + Scatter(i)] = true;
+  }
+  for (size_t round = 0; round < rounds; round++) {
+    registry.roundCounts.push_back(
+        (uint32_t)std::min(fresh - round * combinations, combinations));
+  }
+  registry.count += fresh;
+  return reservation;
 }
+
+// The same kind of name worked out from an id, for builds that do not store
+// one
+inline std::string FromId(uint32_t id) { return Spell(Scatter(id)); }
 } // namespace Names
@@ -0,0 +1,74 @@
+#pragma once
+#include "raylib.h"
+#include <cstdint>
+#include <vector>
+
+class Creature;
+struct World;
+
+// Something a creature can see or touch
+struct SensedObject {
+  uint32_t index;  // Into World::foods or World::creatures
+  float distance;
+  float bearing;   // Radians from the facing direction, -PI..PI
+};
+
+// What one creature perceives this tick, nearest first. Objects inside the
+// creature's touch radius are always sensed; farther ones only when they are
+// within range and inside its field of view.
+struct Senses {
+  static const int NEAREST = 4; // Kept per kind
+
+  uint8_t foodCount = 0;
+  uint8_t creatureCount = 0;
+  SensedObject foods[NEAREST];
+  SensedObject creatures[NEAREST];
+  Vector2 foodScent = {0, 0}; // Food field gradient, when there is a field
+};
+
+// Perception stage: one batched pass that bins food and creatures into a
+// uniform grid and fills a sensor buffer indexed like World::creatures.
+// Behaviour code reads the buffer instead of rescanning the world. Indices
+// refer to this tick's vectors, so the buffer is only valid within a Step.
+class Perception {
+public:
+  // FIELD is whether food is a field, in which case there are no items to
+  // sense and only the scent is read
+  template <bool FIELD> void Update(World &world);
+  const Senses &Get(uint32_t index) const { return senses[index]; }
+
+  // The same readings for a single creature by scanning every object; used
+  // by World::StepReference
+  static Senses Scan(const World &world, const Creature &creature);
+
+  // Every other creature closer than radius to creatures[index], in any
+  // direction and however many there are, nearest first; bearings are left
+  // 0. Searches this tick's grid, and the list is reused by the next call.
+  const std::vector<SensedObject> &Near(const World &world, uint32_t index,
+                                        float radius);
+  // The same by scanning every creature; used by World::StepReference
+  static void ScanNear(const World &world, const Creature &creature,
+                       float radius, std::vector<SensedObject> &nearby);
+
+private:
+  // Objects binned by grid cell, with their positions copied alongside so
+  // the search never touches the objects themselves. cellStart has one
+  // extra entry at the end.
+  struct Grid {
+    uint32_t *cellStart = nullptr;
+    uint32_t *entries = nullptr;
+    Vector2 *positions = nullptr;
+  };
+
+  std::vector<Senses> senses;
+  Vector2 origin = {0, 0};
+  int columns = 0;
+  int rows = 0;
+  Grid foodGrid;
+  Grid creatureGrid;
+  std::vector<SensedObject> nearby; // Returned by Near
+
+  int CellOf(Vector2 position) const;
+  template <typename T>
+  void Bin(Grid &grid, const std::vector<T> &objects, World &world);
+};
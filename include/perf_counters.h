@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+// Hardware events counted around each tick phase
+enum class PerfEvent {
+  CYCLES,
+  INSTRUCTIONS,
+  L1D_MISSES, // Level 1 data cache read misses
+  LLC_MISSES, // Last-level cache misses
+  BRANCH_MISSES,
+  COUNT,
+};
+
+// The calling thread's hardware performance counters, through Linux
+// perf_event_open. Open fails where there are none to be had: on other
+// systems, in containers and VMs that hide them, or when perf_event_paranoid
+// forbids them. Events the CPU lacks are left out and read as zero.
+class PerfCounters {
+public:
+  PerfCounters() = default;
+  ~PerfCounters() { Close(); }
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool Open(); // Starts counting
+  void Close();
+  bool IsOpen() const { return leader >= 0; }
+  bool IsCounting(PerfEvent event) const { return slots[(int)event] >= 0; }
+  const char *GetError() const { return error; } // Why Open last failed
+
+  // Totals since Open, all read in one system call. When the kernel had to
+  // share the counters with other users the totals are scaled up to the
+  // whole time.
+  void Read(uint64_t values[(int)PerfEvent::COUNT]) const;
+
+private:
+  int leader = -1; // Cycles; the other events are opened in its group
+  int files[(int)PerfEvent::COUNT] = {-1, -1, -1, -1, -1};
+  int slots[(int)PerfEvent::COUNT] = {-1, -1, -1, -1, -1}; // In group reads
+  int counted = 0;
+  const char *error = "";
+};
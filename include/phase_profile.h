@@ -0,0 +1,21 @@
+#pragma once
+#include "perf_counters.h"
+#include "world.h"
+#include <cstdint>
+
+// Phase timings and hardware events summed over a run, for the report that
+// --perf-counters logs at the end
+class PhaseProfile {
+public:
+  void Add(const World &world); // After every Step
+  // Per phase: milliseconds per Step and nanoseconds per creature, then with
+  // counters instructions per cycle and L1 data, last-level cache and branch
+  // misses per creature
+  void Log(const char *label, const PerfCounters &counters) const;
+
+private:
+  uint64_t steps = 0;
+  uint64_t creatureSteps = 0; // Creatures summed over Steps
+  double seconds[(int)TickPhase::COUNT] = {};
+  uint64_t events[(int)TickPhase::COUNT][(int)PerfEvent::COUNT] = {};
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+
+// SplitMix64: small, fast, and any seed is a good one. Streams are cheap
+// enough to make one wherever independent draws are needed, which keeps
+// results from depending on the order work is done in.
+class RandomStream {
+public:
+  explicit RandomStream(uint64_t seed) : state(seed) {}
+
+  // Scrambles a key into a seed for a stream of its own
+  static uint64_t Mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+  uint64_t Next() { return Mix(state += 0x9E3779B97F4A7C15ull); }
+  float Uniform() { return (Next() >> 40) * (1.0f / 16777216.0f); } // 0..1
+  // min..max inclusive, like GetRandomValue; a multiply rather than a
+  // division, with a bias too small to matter over these ranges
+  int Range(int min, int max) {
+    return min + (int)(((Next() >> 32) * (uint64_t)(max - min + 1)) >> 32);
+  }
+
+private:
+  uint64_t state;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include "raylib.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class FrameFormat { PNG, RAW };
+
+struct RecorderConfig {
+  std::string directory = "recording";
+  FrameFormat format = FrameFormat::PNG;
+  float interval = 1.0f / 30.0f; // Simulation seconds between frames
+  int width = 0;
+  int height = 0;
+  int workers = 2;
+  int queueDepth = 8; // Frames that may wait for encoding at once
+};
+
+// Records the world to numbered image files at a fixed simulation-time
+// cadence. Frames are drawn into an offscreen render texture and read back
+// asynchronously: each capture queues a copy into a pixel buffer object, and
+// a later one maps that buffer once the GPU has signalled it done and hands
+// the mapping to a worker thread, which flips the rows and encodes them. The
+// buffer is unmapped on the tick thread when the worker is finished with it.
+// When every pixel buffer is in use the frame is dropped instead of making
+// the tick loop wait. So are the frames a tick longer than the interval jumps
+// over. Frame numbers count intervals, so frame n always shows the world at
+// simulation time n * interval, with gaps where frames were dropped.
+class Recorder {
+public:
+  explicit Recorder(const RecorderConfig &config);
+  ~Recorder();
+  Recorder(const Recorder &) = delete;
+  Recorder &operator=(const Recorder &) = delete;
+
+  // Returns true with the offscreen target bound if a frame is due at this
+  // simulation time; draw the world and then call EndFrame
+  bool BeginFrame(double simulationTime);
+  void EndFrame();
+
+  int GetFramesWritten() const;
+  int GetFramesDropped() const { return framesDropped; }
+
+private:
+  struct Job {
+    int slot;
+    uint64_t frame;
+  };
+
+  RecorderConfig config;
+  RenderTexture2D target;
+  uint64_t nextFrame = 0;
+  double nextCaptureTime = 0.0;
+  int framesDropped = 0;
+  bool warnedSkipping = false; // Logged the first tick to jump over frames
+
+  // Pixel buffer objects and their fences and mappings, by slot. Only the
+  // tick thread, which owns the GL context, touches the GL objects and the
+  // free and in-flight lists
+  std::vector<unsigned int> pixelBuffers;
+  std::vector<void *> fences;
+  std::vector<const unsigned char *> mappings;
+  std::vector<int> freeSlots;
+  std::vector<Job> inFlight; // Read back but maybe not finished, oldest first
+
+  // Shared with the workers, guarded by mutex
+  std::vector<Job> queue; // Ring with room for every slot
+  int queueHead = 0;
+  int queueCount = 0;
+  std::vector<int> finishedSlots; // Encoded, waiting to be unmapped
+  int framesWritten = 0;
+  bool stopping = false;
+  mutable std::mutex mutex;
+  std::condition_variable jobReady;
+  std::vector<std::vector<unsigned char>> flipBuffers; // One per worker
+  std::vector<std::thread> workers;
+
+  // Unmaps the slots the workers are done with and queues every finished
+  // readback, waiting for the GPU if wait is set
+  void Collect(bool wait);
+  void WorkerLoop(int worker);
+  void Encode(const Job &job, std::vector<unsigned char> &flipped);
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include "raylib.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct World;
+
+// Everything a tick depends on besides the world itself
+struct TickInput {
+  float deltaTime;
+  Rectangle focusRegion; // Only matters under multi-rate updates
+  uint32_t focusId;
+};
+
+// Scrubbing back through the recent past. Every interval ticks the world is
+// saved as a keyframe, which a background thread compresses into a ring kept
+// within a memory budget, and the input of every tick since the oldest
+// keyframe is journaled. Seeking restores the nearest earlier keyframe and
+// re-simulates forward with the journaled inputs. The random generator is
+// reseeded from the tick number on keyframe ticks, so re-simulated ticks
+// draw the same numbers as the originals.
+class Rewind {
+public:
+  typedef std::function<void(const TickInput &)> TickFn;
+
+  Rewind(size_t budgetBytes, uint32_t interval);
+  ~Rewind();
+  Rewind(const Rewind &) = delete;
+  Rewind &operator=(const Rewind &) = delete;
+
+  // Call before every tick, live or replayed, with the input it runs on. On
+  // the live edge this also journals the input and takes due keyframes.
+  void BeginTick(World &world, const TickInput &input);
+  // Brings the world to tick, clamped to the ticks still covered, by
+  // replaying from the nearest earlier keyframe with runTick. Returns the
+  // tick reached.
+  uint64_t Seek(World &world, uint64_t tick, const TickFn &runTick);
+  void Clear(); // Forgets everything, e.g. after a restart
+
+  bool IsReplaying(const World &world) const;
+  const TickInput &GetInput(uint64_t tick) const; // Journaled ticks only
+  uint64_t GetLiveTick() const { return liveTick; }
+  uint64_t GetOldestTick() const;
+  size_t GetMemoryBytes() const;
+
+private:
+  static const size_t MAX_PENDING = 2; // Raw keyframes awaiting compression
+
+  struct Keyframe {
+    uint64_t tick;
+    std::vector<uint8_t> data;
+  };
+
+  size_t budgetBytes;
+  uint32_t interval;
+  uint32_t seed; // Mixed into every reseed, fixed for the session
+
+  // Main thread only
+  std::deque<TickInput> journal; // Input of tick journalStart + i
+  uint64_t journalStart = 0;
+  uint64_t liveTick = 0; // First tick not yet simulated live
+
+  // Shared with the worker
+  std::deque<Keyframe> keyframes; // Compressed, oldest first
+  size_t keyframeBytes = 0;
+  std::deque<Keyframe> pending; // Saved, not yet compressed
+  bool compressing = false;
+  bool stopping = false;
+  mutable std::mutex mutex;
+  std::condition_variable jobReady;
+  std::condition_variable idle;
+  std::thread worker;
+
+  void Reseed(uint64_t tick) const;
+  void TrimJournal();
+  void WorkerLoop();
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include "world_gen.h"
+#include <string>
+
+// What a scenario chooses beyond the values in Constants. World::Step runs
+// a tick kernel built for each combination of subsystems, so a disabled one
+// is compiled out of the tick rather than skipped by a branch per creature.
+struct ScenarioFeatures {
+  bool contagion = true; // Sick creatures infect those nearby
+  bool fighting = true;  // Fights over food and mates
+  bool foodField = false; // Food as a density field instead of items
+  Layout creatureLayout = Layout::UNIFORM; // Where the founders start
+  Layout foodLayout = Layout::UNIFORM;     // And the initial food
+};
+
+// Scenario files set world parameters at startup, so parameter sweeps need
+// no rebuild. Each line is "name = value", with # starting a comment:
+//
+//   # Crowded, peaceful, slow to starve
+//   initial_creature_count = 400
+//   energy_consumption_rate = 6
+//   fighting = off
+//   food = field
+//
+// Names are those of the variables in Constants, in either case. The
+// toggles are contagion and fighting (on or off) and food (items or field),
+// and creature_layout and food_layout take uniform, clustered or poisson.
+// Values must be in bounds for the parameter (intervals, rates and the
+// perception range positive, for instance), and each MIN_ no larger than
+// its MAX_; a line breaking either is reported and left out.
+namespace Scenario {
+// Applies every valid line, warning about the rest; false if the file could
+// not be read or any line was rejected
+bool Load(const std::string &path, ScenarioFeatures &features);
+} // namespace Scenario
@@ -0,0 +1,49 @@
+#pragma once
+#include "trait_stats.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a SeedStats run simulates, and how far apart two builds may be
+struct SeedStatsConfig {
+  unsigned firstSeed = 1;
+  int seeds = 6;
+  int creatureCount = 300;
+  bool brains = false;
+  bool foodField = false;
+  bool contagion = true;
+  bool fighting = true;
+  uint64_t ticks = 4000;
+  float allowance = 3.0f; // Standard errors of the difference in means
+};
+
+// Mean population and trait means over a run, for each of several seeds.
+// Builds that store creatures differently (make COMPACT=1) are not
+// bit-identical, so holding one to the other is statistical: Save the means
+// from one build, then Compare the same run of the other against them. A
+// measure agrees when the two builds' averages over the seeds are within
+// the allowance of standard errors of each other.
+class SeedStats {
+public:
+  static const int MEASURES = 1 + (int)Trait::COUNT; // Population first
+
+  explicit SeedStats(const SeedStatsConfig &config) : config(config) {}
+
+  void Run();
+  bool Save(const std::string &path) const;
+  bool Compare(const std::string &path); // Whether every measure agrees
+  // After Compare, a line per measure: both averages and the allowance
+  const std::string &GetReport() const { return report; }
+
+private:
+  struct Means {
+    unsigned seed;
+    double values[MEASURES];
+  };
+
+  SeedStatsConfig config;
+  std::vector<Means> runs; // One per seed
+  std::string report;
+
+  static const char *GetName(int measure);
+};
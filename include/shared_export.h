@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct World;
+
+// Layout of the shared-memory region (host byte order, no padding between
+// fields). The region is a SharedHeader followed by the columns, each
+// starting at the byte offset given in the header and holding capacity
+// entries, of which the first count are valid:
+//
+//   creatures  u32 id, f32 x, f32 y, u8 state, f32 health, f32 energy,
+//              f32 age, f32 strength, f32 speed, f32 metabolism, f32 size
+//   foods      f32 x, f32 y
+//
+// Readers map the region once and use the sequence number as a seqlock:
+// read it, copy what they need, then read it again. The copy is consistent
+// if both reads return the same even value; an odd value means a publish is
+// in progress.
+namespace SharedLayout {
+const uint32_t MAGIC = 0x4D485343u; // "CSHM"
+const uint32_t VERSION = 1;
+
+enum CreatureColumn {
+  ID,
+  X,
+  Y,
+  STATE,
+  HEALTH,
+  ENERGY,
+  AGE,
+  STRENGTH,
+  SPEED,
+  METABOLISM,
+  SIZE,
+  CREATURE_COLUMN_COUNT,
+};
+enum FoodColumn { FOOD_X, FOOD_Y, FOOD_COLUMN_COUNT };
+
+struct SharedHeader {
+  uint32_t magic;
+  uint32_t version;
+  std::atomic<uint64_t> sequence; // Odd while the writer is publishing
+  uint64_t tick;
+  double simulationTime;
+  float worldWidth;
+  float worldHeight;
+  uint32_t creatureCapacity;
+  uint32_t creatureCount; // Rows written; at most creatureCapacity
+  uint32_t creatureTotal; // Living creatures, which may exceed the capacity
+  uint32_t foodCapacity;
+  uint32_t foodCount;
+  uint32_t foodTotal;
+  uint64_t creatureOffsets[CREATURE_COLUMN_COUNT];
+  uint64_t foodOffsets[FOOD_COLUMN_COUNT];
+};
+} // namespace SharedLayout
+
+// Publishes the hot creature and food fields into a POSIX shared-memory
+// object as fixed-capacity columns, so that analysis tools can map it once
+// and read live snapshots without copies or syscalls on the simulation side.
+class SharedExport {
+public:
+  SharedExport() = default;
+  ~SharedExport();
+  SharedExport(const SharedExport &) = delete;
+  SharedExport &operator=(const SharedExport &) = delete;
+
+  // name is a shm_open name such as "/creaturesim"
+  bool Open(const std::string &name, uint32_t creatureCapacity,
+            uint32_t foodCapacity, float worldWidth, float worldHeight);
+  void Close();
+  bool IsOpen() const { return header != nullptr; }
+
+  void Publish(const World &world);
+
+  size_t GetRegionBytes() const { return regionBytes; }
+
+private:
+  std::string name;
+  void *region = nullptr;
+  size_t regionBytes = 0;
+  SharedLayout::SharedHeader *header = nullptr;
+
+  template <typename T> T *Column(uint64_t offset) {
+    return reinterpret_cast<T *>(static_cast<unsigned char *>(region) +
+                                 offset);
+  }
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct World;
+
+// Wire format (host byte order; every frame starts with a FrameHeader):
+//
+//   KEYFRAME  recordCount x {u32 id, u16 x, u16 y, u8 state, u8 health,
+//                            u8 energy}
+//   DELTA     recordCount x {u32 id, u8 fieldMask, [u16 x, u16 y] if
+//                            POSITION, [u8 state] if STATE, [u8 health] if
+//                            HEALTH, [u8 energy] if ENERGY}
+//             removedCount x u32 id
+//
+// Positions are quantized to 16 bits across the world size, health and
+// energy to 8 bits across 0-100. A delta only carries creatures whose
+// quantized fields changed since the previous frame, plus the ids that died.
+namespace Snapshot {
+const uint32_t MAGIC = 0x504E5343u; // "CSNP"
+
+enum FrameType : uint8_t { KEYFRAME = 1, DELTA = 2 };
+enum FieldMask : uint8_t {
+  POSITION = 1 << 0,
+  STATE = 1 << 1,
+  HEALTH = 1 << 2,
+  ENERGY = 1 << 3,
+  ALL_FIELDS = POSITION | STATE | HEALTH | ENERGY,
+};
+
+struct FrameHeader {
+  uint32_t magic;
+  uint8_t type;
+  uint8_t reserved[3];
+  uint64_t tick;
+  float worldWidth;
+  float worldHeight;
+  uint32_t recordCount;
+  uint32_t removedCount;
+  uint32_t payloadBytes; // Bytes following the header
+};
+
+struct CreatureRecord {
+  uint16_t x;
+  uint16_t y;
+  uint8_t state;
+  uint8_t health;
+  uint8_t energy;
+};
+
+// Rebuilds the world view from a byte stream; for viewers written in C++
+class Decoder {
+public:
+  // Consumes as many whole frames as data holds; returns bytes used
+  size_t Consume(const uint8_t *data, size_t size);
+  const std::unordered_map<uint32_t, CreatureRecord> &GetCreatures() const {
+    return creatures;
+  }
+  uint64_t GetTick() const { return tick; }
+
+private:
+  std::unordered_map<uint32_t, CreatureRecord> creatures;
+  uint64_t tick = 0;
+};
+} // namespace Snapshot
+
+// Publishes quantized world frames on a local Unix-domain socket. Viewers
+// may connect at any time and receive a keyframe followed by per-tick deltas.
+// Sockets are non-blocking; a viewer that falls too far behind is
+// disconnected instead of slowing the simulation.
+class SnapshotServer {
+public:
+  SnapshotServer() = default;
+  ~SnapshotServer();
+  SnapshotServer(const SnapshotServer &) = delete;
+  SnapshotServer &operator=(const SnapshotServer &) = delete;
+
+  bool Open(const std::string &path, float worldWidth, float worldHeight);
+  void Close();
+  bool IsOpen() const { return listenFd >= 0; }
+
+  void Publish(const World &world, uint64_t tick);
+
+  int GetClientCount() const { return (int)clients.size(); }
+  size_t GetLastDeltaBytes() const { return lastDeltaBytes; }
+
+  static const int KEYFRAME_INTERVAL = 600;         // Ticks
+  static const size_t MAX_CLIENT_BACKLOG = 8 << 20; // Bytes
+
+private:
+  struct Client {
+    int fd;
+    bool needsKeyframe;
+    std::vector<uint8_t> pending;
+    size_t sent;
+  };
+  struct Tracked {
+    Snapshot::CreatureRecord record;
+    uint32_t seen; // Publish generation that last saw this id
+  };
+
+  std::string path;
+  int listenFd = -1;
+  float worldWidth = 1.0f;
+  float worldHeight = 1.0f;
+  std::vector<Client> clients;
+  std::unordered_map<uint32_t, Tracked> tracked;
+  uint32_t generation = 0;
+  uint64_t lastKeyframeTick = 0;
+  std::vector<uint8_t> keyframe;
+  std::vector<uint8_t> delta;
+  std::vector<uint32_t> removed;
+  size_t lastDeltaBytes = 0;
+
+  void AcceptClients();
+  void Encode(const World &world, uint64_t tick, bool wantKeyframe);
+  void Send(Client &client, const std::vector<uint8_t> &frame);
+  bool Flush(Client &client);
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Arena;
+struct World;
+
+// One look at the process during a soak run
+struct SoakSample {
+  double simulationTime;
+  uint64_t residentBytes; // 0 where the system does not say
+  uint64_t allocations;   // Since the last sample; debug builds only
+  float p50;              // Tick latency since the last sample, milliseconds
+  float p99;
+  uint32_t population;
+  size_t creatureCapacity;
+  size_t foodCapacity;
+  size_t nameCount; // Names handed out so far
+  size_t arenaBytes; // Tick and frame arena buffers
+};
+
+// Watches a long headless run (--soak) for slow leaks and slowdowns. Every
+// SOAK_SAMPLE_INTERVAL simulated seconds it samples memory, container sizes
+// and the spread of tick times. At the end it fits a line through each
+// series past the warm-up, and fails the run on resident memory growth or
+// p99 latency drift over the limits in Constants.
+class SoakMonitor {
+public:
+  // After every tick, with the wall-clock seconds it took
+  void Record(const World &world, double seconds, const Arena &frameArena);
+  void NoteRestart() { restarts++; } // The population died out
+  bool Report() const; // Logs the slopes; whether they are within limits
+
+private:
+  std::vector<float> tickMilliseconds; // Since the last sample
+  std::vector<SoakSample> samples;
+  double nextSampleTime = 0.0;
+  uint64_t allocationsAtSample = 0;
+  int restarts = 0;
+
+  void Sample(const World &world, const Arena &frameArena);
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class TimerKind : uint8_t {
+  EATING_DONE,
+  MATING_COOLDOWN,
+  FIGHT_COOLDOWN,
+  SICK_RECOVERY,
+  COUNT,
+};
+
+struct TimerEvent {
+  uint32_t creatureId;
+  uint32_t token; // Lets the owner ignore timers it has since restarted
+  TimerKind kind;
+};
+
+// Hierarchical timer wheel counted in simulation ticks. Level 0 has one slot
+// per tick; every higher level covers a full turn of the level below and is
+// cascaded down when that turn completes, so scheduling and expiry are O(1)
+// and only due timers are ever touched.
+class TimerWheel {
+public:
+  static const int LEVELS = 4;
+  static const int SLOT_BITS = 6;
+  static const int SLOTS = 1 << SLOT_BITS;
+
+  TimerWheel();
+  void Schedule(const TimerEvent &event, uint64_t delayTicks);
+  void Advance(uint64_t toTick, std::vector<TimerEvent> &fired);
+  void Clear(uint64_t tick = 0); // Empties the wheel and restarts it at tick
+
+  uint64_t GetTick() const { return now; }
+  size_t GetPendingCount() const { return pending; }
+
+private:
+  static const uint32_t NONE = 0xFFFFFFFFu;
+
+  struct Node {
+    uint64_t expires;
+    TimerEvent event;
+    uint32_t next;
+  };
+
+  std::vector<Node> nodes; // Arena shared by every slot list
+  std::vector<uint32_t> freeNodes;
+  uint32_t slots[LEVELS][SLOTS];
+  uint64_t now = 0;
+  size_t pending = 0;
+
+  void Insert(uint32_t node);
+  void Cascade(int level);
+};
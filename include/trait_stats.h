@@ -0,0 +1,64 @@
+#pragma once
+#include "constants.h"
+
+enum class Trait { STRENGTH, SPEED, METABOLISM, SIZE, COUNT };
+
+// The heritable/growable traits of one creature at one moment
+struct TraitSample {
+  float values[(int)Trait::COUNT];
+
+  float operator[](Trait trait) const { return values[(int)trait]; }
+};
+
+// Fixed-range histogram plus raw moments of one trait. Samples can be removed
+// again, so it is maintained as creatures are born, die or change rather than
+// rebuilt from the population.
+class TraitHistogram {
+public:
+  static const int BINS = Constants::TRAIT_HISTOGRAM_BINS;
+
+  TraitHistogram(float min = 0.0f, float max = 1.0f);
+  void Add(float value);
+  void Remove(float value);
+  void Clear();
+
+  int GetCount() const { return count; }
+  float GetMean() const;
+  float GetStdDev() const;
+  float GetMinEdge() const { return min; }
+  float GetMaxEdge() const { return max; }
+  float GetBinWidth() const { return (max - min) / BINS; }
+  int GetBin(int index) const { return bins[index]; }
+  int GetPeakBin() const;
+  float GetObservedMin() const; // Lower edge of the lowest occupied bin
+  float GetObservedMax() const; // Upper edge of the highest occupied bin
+
+private:
+  float min;
+  float max;
+  int bins[BINS];
+  int count;
+  // Doubles keep add/remove round trips from drifting over long runs
+  double sum;
+  double sumSquares;
+
+  int BinOf(float value) const;
+};
+
+// Population-wide distribution of every Trait
+class TraitStats {
+public:
+  TraitStats();
+  void Add(const TraitSample &sample);
+  void Remove(const TraitSample &sample);
+  void Replace(const TraitSample &before, const TraitSample &after);
+  void Clear();
+
+  const TraitHistogram &Get(Trait trait) const {
+    return histograms[(int)trait];
+  }
+  static const char *GetName(Trait trait);
+
+private:
+  TraitHistogram histograms[(int)Trait::COUNT];
+};
@@ -0,0 +1,133 @@
+#pragma once
+#include "creature.h"
+#include "raylib.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct World;
+
+// File format (host byte order). A FileHeader, then one chunk per
+// CHUNK_TICKS ticks, appended as the simulation runs:
+//
+//   blocks    one per creature alive during the chunk:
+//               varint first tick - chunk first tick, varint sample count,
+//               svarint x, svarint y                 keyframe
+//               (count - 1) x {svarint dx, svarint dy}  one per tick
+//               varint run count, runs x {varint length, u8 state}
+//               varint gap count, gaps x {varint sample, varint ticks}
+//   index     ChunkIndex, then entryCount IndexEntry sorted by id
+//   trailer   Trailer, pointing back at the index
+//
+// Positions are fixed point with POSITION_SCALE steps per world unit.
+// Samples are one tick apart except where a gap says the creature was
+// missing, e.g. away on another tile, for some ticks before that sample.
+// Every index links to the one before it, so a reader follows the chain
+// back from the last trailer and then reads only the blocks it asks for.
+namespace TrajectoryFormat {
+const uint32_t MAGIC = 0x4A525443u;       // "CTRJ"
+const uint32_t INDEX_MAGIC = 0x58525443u; // "CTRX"
+const uint32_t VERSION = 1;
+const uint32_t CHUNK_TICKS = 600;
+const float POSITION_SCALE = 8.0f;
+const uint64_t NO_INDEX = ~0ull;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  float positionScale;
+  uint32_t chunkTicks;
+};
+
+struct ChunkIndex {
+  uint32_t magic;
+  uint32_t entryCount;
+  uint64_t firstTick;
+  uint64_t lastTick;
+  uint64_t previousIndex; // Byte offset, NO_INDEX for the first chunk
+};
+
+struct IndexEntry {
+  uint32_t id;
+  uint32_t blockBytes;
+  uint64_t blockOffset;
+};
+
+struct Trailer {
+  uint64_t indexOffset;
+  uint32_t magic;
+  uint32_t reserved;
+};
+} // namespace TrajectoryFormat
+
+// Appends the path and state of every creature after each tick
+class TrajectoryWriter {
+public:
+  TrajectoryWriter() = default;
+  ~TrajectoryWriter();
+  TrajectoryWriter(const TrajectoryWriter &) = delete;
+  TrajectoryWriter &operator=(const TrajectoryWriter &) = delete;
+
+  bool Open(const std::string &path);
+  void Close(); // Writes out the chunk in progress
+  bool IsOpen() const { return file != nullptr; }
+  // After each Step, once per tick. Ghosts are left to the tile that owns
+  // them. A tick count that goes backwards, as after a restart, starts a
+  // new chunk.
+  void Record(const World &world);
+
+private:
+  // One creature's samples in the chunk in progress
+  struct Track {
+    uint64_t firstTick;
+    uint64_t lastTick;
+    uint32_t count = 0;
+    int32_t x;
+    int32_t y;
+    std::vector<uint8_t> positions;
+    std::vector<std::pair<uint32_t, CreatureState>> states; // Runs
+    std::vector<std::pair<uint32_t, uint64_t>> gaps; // Sample, ticks missed
+  };
+
+  FILE *file = nullptr;
+  uint64_t offset = 0; // Bytes written so far
+  uint64_t previousIndex = TrajectoryFormat::NO_INDEX;
+  uint64_t chunkFirstTick = 0;
+  uint64_t lastTick = 0;
+  std::unordered_map<uint32_t, Track> tracks;
+  std::vector<uint8_t> buffer;
+
+  void FlushChunk();
+  void Write(const void *data, size_t size);
+};
+
+// Reads creatures' histories back from a trajectory file
+class TrajectoryReader {
+public:
+  struct Sample {
+    uint64_t tick;
+    Vector2 position;
+    CreatureState state;
+  };
+
+  ~TrajectoryReader();
+  bool Open(const std::string &path); // Loads the indices, not the blocks
+  // Appends the creature's samples with firstTick <= tick <= lastTick in
+  // tick order; false if the file is damaged
+  bool Read(uint32_t id, uint64_t firstTick, uint64_t lastTick,
+            std::vector<Sample> &out);
+  size_t GetChunkCount() const { return chunks.size(); }
+
+private:
+  struct Chunk {
+    uint64_t firstTick;
+    uint64_t lastTick;
+    std::vector<TrajectoryFormat::IndexEntry> entries;
+  };
+
+  FILE *file = nullptr;
+  float positionScale = TrajectoryFormat::POSITION_SCALE;
+  std::vector<Chunk> chunks; // Oldest first
+};
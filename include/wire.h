@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Appending and reading plain values in host byte order, for the formats
+// that only ever travel between processes on one machine
+namespace Wire {
+template <typename T>
+inline void Put(std::vector<uint8_t> &out, const T &value) {
+  size_t at = out.size();
+  out.resize(at + sizeof(T));
+  std::memcpy(&out[at], &value, sizeof(T));
+}
+
+template <typename T>
+inline bool Get(const uint8_t *&cursor, const uint8_t *end, T &value) {
+  if ((size_t)(end - cursor) < sizeof(T)) {
+    return false;
+  }
+  std::memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return true;
+}
+
+// LEB128: seven bits per byte, low bits first, high bit set on all but the
+// last byte. Signed values are zigzag mapped first so that small magnitudes
+// of either sign stay short.
+inline void PutVarint(std::vector<uint8_t> &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+}
+
+inline bool GetVarint(const uint8_t *&cursor, const uint8_t *end,
+                      uint64_t &value) {
+  value = 0;
+  for (int shift = 0; cursor < end && shift < 64; shift += 7) {
+    uint8_t byte = *cursor++;
+    value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline void PutSignedVarint(std::vector<uint8_t> &out, int64_t value) {
+  PutVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+inline bool GetSignedVarint(const uint8_t *&cursor, const uint8_t *end,
+                            int64_t &value) {
+  uint64_t zigzag;
+  if (!GetVarint(cursor, end, zigzag)) {
+    return false;
+  }
+  value = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+  return true;
+}
+} // namespace Wire
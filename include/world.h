@@ -0,0 +1,217 @@
+#pragma once
+#include "arena.h"
+#include "brain.h"
+#include "creature.h"
+#include "food.h"
+#include "food_field.h"
+#include "interaction.h"
+#include "lineage.h"
+#include "perception.h"
+#include "perf_counters.h"
+#include "random_stream.h"
+#include "raylib.h"
+#include "timer_wheel.h"
+#include "trait_stats.h"
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Stages of World::Step, in the order they run
+enum class TickPhase {
+  TIMERS,
+  FOOD_FIELD,
+  VITALS,
+  PERCEPTION,
+  THINKING,
+  FEEDING,
+  DECISION,
+  INTERACTION,
+  CONTAGION,
+  MOVEMENT,
+  BIRTHS_AND_DEATHS,
+  REORDER,
+  COUNT,
+};
+
+// How often a creature is updated under multi-rate updates, most often first
+enum class ActivityTier {
+  FOCUS, // On screen or selected: every Step
+  NEAR,  // Just off screen
+  FAR,
+  COUNT,
+};
+
+// What a creature draws random numbers for, so that no two share a stream
+enum class RandomPurpose : uint8_t {
+  SEARCH,      // Wandering while hunting for food
+  WANDER,      // Wandering in the movement phase
+  FIGHT_ODDS,  // Sizing up one opponent
+  INTERACTION, // A fight's outcome, or a child's traits and genome
+  CONTAGION,   // Whether one neighbour catches it
+};
+
+struct World;
+
+// A creature that touched food another tile owns. Whether it eats is the
+// owner's call, as it may have other takers.
+struct FoodClaim {
+  uint32_t claimantId;
+  Vector2 position; // Of the food
+  float distance;   // Between the two
+};
+
+// Domain decomposition: eating, fights, matings and infections that reach
+// across a tile border are settled by the tile that owns the food or the
+// creature touched. Step hands over at the point a single world would apply
+// them, and the claims and outcomes it collected are settled before Step
+// goes on. DomainNode implements this.
+class ClaimExchange {
+public:
+  virtual ~ClaimExchange() = default;
+  // After feeding: World::foodClaims go to the food's owners, and each
+  // claimant accepted eats
+  virtual void SettleFood(World &world) = 0;
+  // After matching: the claims in World::interactions go to the partners'
+  // owners, which Accept them or not
+  virtual void SettleClaims(World &world) = 0;
+  // After contagion: interaction outcomes for proposers and the infections
+  // of ghosts go to the creatures' owners, which apply them
+  virtual void SettleOutcomes(World &world) = 0;
+};
+
+// Everything the simulation tick reads or writes
+struct World {
+  std::vector<Creature> creatures;
+  std::vector<Food> foods;
+  FoodField foodField; // Replaces foods once Reset
+  std::vector<Creature> births; // Children spawned during the current tick
+  std::vector<Genome> birthGenomes; // Theirs, in order, in brain mode only
+  std::vector<std::pair<uint32_t, uint32_t>> birthParents; // Theirs, in order
+  Lineage lineage;
+  TraitStats traitStats;
+  TimerWheel timers;
+  bool brainsEnabled = false; // Brains steer and gate mating and fighting
+  bool contagionEnabled = true; // Sick creatures infect those nearby
+  bool fightingEnabled = true;  // Creatures fight over food and mates
+  BrainBatch brains;          // Entry i belongs to creatures[i]; brain mode
+  std::vector<CreatureTimers> creatureTimers; // Entry i is creatures[i]'s
+  Perception perception;      // What creatures[i] senses this tick
+  InteractionStage interactions; // Fights and matings proposed this tick
+
+  // Multi-rate updates. Creatures outside the focus region update every few
+  // Steps with the time they missed; the focus creature always updates.
+  bool multiRate = false;
+  Rectangle focusRegion = {0, 0, 0, 0}; // World space, usually the viewport
+  uint32_t focusId = Lineage::NONE;
+  uint32_t tierCounts[(int)ActivityTier::COUNT] = {}; // During the last Step
+  // Domain decomposition: ghosts of creatures and food owned by neighbouring
+  // tiles sit alongside the local ones between DomainNode's halo exchange and
+  // RemoveGhosts. Step senses and touches them but never updates, removes or
+  // counts them; what it would do to them becomes a claim settled through
+  // claimExchange.
+  ClaimExchange *claimExchange = nullptr;
+  std::vector<FoodClaim> foodClaims; // Ghost food touched this Step
+  std::vector<uint32_t> ghostInfections; // Ids of ghosts infected this Step
+  float foodSpawnTimer = 0.0f; // Seconds since food last spawned
+  double simulationTime = 0.0;
+  uint64_t tickCount = 0; // Steps taken since the last Clear
+  uint64_t seed = 0;      // Keys the creatures' random streams; see RandomFor
+
+  // Position of each living creature in creatures, by id. Its nodes are
+  // recycled through idNodes, so births after deaths do not allocate.
+  NodePool idNodes;
+  PooledMap<uint32_t, uint32_t> indexById{
+      PoolAllocator<std::pair<const uint32_t, uint32_t>>(&idNodes)};
+  std::vector<TimerEvent> firedTimers; // Scratch space reused every tick
+  std::vector<Creature> reordered;     // Scratch space for ReorderStorage
+
+  // Scratch memory for the current Step, released when it returns
+  Arena tickArena;
+  // Indices into creatures grouped by state, refreshed between phases. The
+  // buckets are consecutive runs of one tick-arena array.
+  uint32_t *bucketIndices = nullptr;
+  // Simulated seconds each creature advances this Step, negative for those
+  // sitting it out. Only active creatures are bucketed.
+  float *stepTimes = nullptr;
+  // What each active creature's brain decided this Step; brain mode
+  BrainOutput *thoughts = nullptr;
+  uint32_t bucketStart[(int)CreatureState::COUNT + 1] = {};
+  // Wall-clock seconds each phase took during the last Step
+  double phaseSeconds[(int)TickPhase::COUNT] = {};
+  // Hardware counters to read around every phase, if set and open, and the
+  // events each phase counted during the last Step
+  PerfCounters *perfCounters = nullptr;
+  uint64_t phaseEvents[(int)TickPhase::COUNT][(int)PerfEvent::COUNT] = {};
+
+  void Clear();
+  // Complete simulation state between Steps, with how far Names has got.
+  // Restoring it and replaying the same inputs with the same random seed
+  // reproduces the same Steps and names the same children.
+  void Save(std::vector<uint8_t> &out) const;
+  bool Load(const uint8_t *data, size_t size);
+  void SpawnCreature(Vector2 pos, float size);
+  // Runs the StepKernel built for the subsystems switched on
+  void Step(float deltaTime);
+  // One Step with the feature toggles fixed at compile time, so that the
+  // phases of a switched-off subsystem are left out entirely. FIELD is
+  // whether food is a field rather than items.
+  template <bool CONTAGION, bool FIGHTING, bool FIELD>
+  void StepKernel(float deltaTime);
+  // The same tick without the machinery that makes Step fast, and with its
+  // own copy of the rules (Creature::Reference): each phase is a plain loop
+  // over the creatures, which scan every other creature and food instead of
+  // the perception grid and think one brain at a time, with the feature
+  // toggles and multi-rate turns checked as they come. Slow, but the
+  // baseline the Differential harness holds Step to. Tiles are not modelled.
+  void StepReference(float deltaTime);
+  // The parts of a Step both engines share, with ReorderStorage
+  void FireTimers(float deltaTime); // Advances the clock and the timer wheel
+  void SettleBirthsAndDeaths(); // Admits births, removes the dead and eaten
+  Creature *Find(uint32_t id);
+  // Both return or take the wheel tick the timer falls due on
+  uint64_t ScheduleTimer(const TimerEvent &event, float seconds);
+  void ScheduleTimerAt(const TimerEvent &event, uint64_t dueTick);
+  // Creature::Write and Read plus the timers, and the genome in brain mode,
+  // for snapshots and for creatures crossing between tiles
+  void WriteCreature(uint32_t index, std::vector<uint8_t> &out) const;
+  bool ReadCreature(const uint8_t *&cursor, const uint8_t *end,
+                    Creature &creature, CreatureTimers &timers,
+                    Genome &genome) const;
+  void AddGhost(const Creature &ghost, const Genome &genome);
+  void AddGhostFood(Vector2 position);
+  void RemoveGhosts();
+  // Arrived from another tile, placed as it was in that tile's family tree
+  void Adopt(const Creature &creature, const CreatureTimers &timers,
+             const Genome &genome, const Lineage::Placement &placement);
+  Creature Release(uint32_t index); // Leaving for another tile
+  void BucketByState();
+  // Sorts creatures along a Morton curve over their positions once too many
+  // neighbours in storage are out of curve order; returns whether it did.
+  // Only indices change: ids, timers and the selection are unaffected.
+  bool ReorderStorage();
+  ActivityTier GetTier(const Creature &creature) const;
+  // The random numbers creature id draws this Step for purpose, about the
+  // creature other where there is one. Each comes from a stream keyed by
+  // those and the tick rather than from one shared generator, so the draws
+  // are the same whatever order creatures are visited in: both engines,
+  // every tile and a replay see the same ones.
+  RandomStream RandomFor(uint32_t id, RandomPurpose purpose,
+                         uint32_t other = 0) const;
+  bool IsActive(uint32_t index) const { return stepTimes[index] >= 0.0f; }
+
+  template <typename Fn> void ForEachInState(CreatureState state, Fn fn) {
+    for (uint32_t i = bucketStart[(int)state]; i < bucketStart[(int)state + 1];
+         i++) {
+      fn(creatures[bucketIndices[i]]);
+    }
+  }
+  // Like ForEachInState, passing the index into creatures instead
+  template <typename Fn> void ForEachIndexInState(CreatureState state, Fn fn) {
+    for (uint32_t i = bucketStart[(int)state]; i < bucketStart[(int)state + 1];
+         i++) {
+      fn(bucketIndices[i]);
+    }
+  }
+};
@@ -0,0 +1,41 @@
+#pragma once
+#include "raylib.h"
+#include <cstdint>
+#include <functional>
+
+struct World;
+
+// How WorldGen spreads creatures or food over the bounds
+enum class Layout {
+  UNIFORM,
+  CLUSTERED,    // Gaussian patches around random centres
+  POISSON_DISC, // Random, but never closer together than the spacing
+};
+
+struct WorldGenConfig {
+  Rectangle bounds = {0, 0, 0, 0};
+  uint64_t seed = 1;
+  int creatureCount = 0;
+  int foodCount = 0;
+  Layout creatureLayout = Layout::UNIFORM;
+  Layout foodLayout = Layout::UNIFORM;
+  int clusters = 8;
+  float clusterSpread = 0.05f; // Standard deviation, share of the short side
+  int threads = 0;             // 0 for one per hardware thread
+  // When set, only what lands where this holds is added. Everything is
+  // still drawn, ids and names included, so each part matches the whole.
+  std::function<bool(Vector2)> keep;
+};
+
+// Bulk world generation for large starts. Storage is sized once, then
+// positions and founder traits are filled in parallel, each block of
+// creatures or food drawing from its own stream seeded from the config's
+// seed. The shared random generator is not touched, and the result is the
+// same whatever the thread count. Ids and names are reserved in one go, so
+// the id index and family tree fill on a thread of their own meanwhile.
+namespace WorldGen {
+// Appends the creatures and food to the world
+void Generate(World &world, const WorldGenConfig &config);
+// "uniform", "clustered" or "poisson"
+bool ParseLayout(const char *name, Layout &layout);
+} // namespace WorldGen
@@ -0,0 +1,51 @@
+#include "alloc_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef COUNT_ALLOCATIONS
+static std::atomic<uint64_t> allocationCount(0);
+
+#if defined(__GLIBC__)
+// glibc lets a program define malloc and friends in place of its own, and
+// keeps the originals under these names; operator new comes through here too
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *memory, size_t size);
+
+void *malloc(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+void *calloc(size_t count, size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(count, size);
+}
+void *realloc(void *memory, size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(memory, size);
+}
+}
+#else
+static void *CountedAllocate(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  void *memory = std::malloc(size > 0 ? size : 1);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void *operator new(std::size_t size) { return CountedAllocate(size); }
+void *operator new[](std::size_t size) { return CountedAllocate(size); }
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+#endif
+
+uint64_t AllocCounter::GetCount() {
+  return allocationCount.load(std::memory_order_relaxed);
+}
+#else
+uint64_t AllocCounter::GetCount() { return 0; }
+#endif
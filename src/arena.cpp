@@ -0,0 +1,100 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+Arena::Arena(size_t capacity)
+    : buffer(static_cast<char *>(std::malloc(capacity))), capacity(capacity) {
+  if (!buffer) {
+    throw std::bad_alloc();
+  }
+}
+
+Arena::~Arena() {
+  Reset();
+  std::free(buffer);
+}
+
+void *Arena::Allocate(size_t bytes, size_t alignment) {
+  uintptr_t base = reinterpret_cast<uintptr_t>(buffer);
+  size_t aligned = (size_t)((base + offset + alignment - 1) &
+                            ~(uintptr_t)(alignment - 1)) -
+                   base;
+
+  if (aligned + bytes <= capacity) {
+    offset = aligned + bytes;
+    if (GetUsed() > highWater)
+      highWater = GetUsed();
+    return buffer + aligned;
+  }
+
+  // Out of room for this cycle; malloc aligns for any fundamental type
+  void *block = std::malloc(bytes > 0 ? bytes : 1);
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  overflow.push_back(block);
+  overflowBytes += bytes + alignment;
+  if (GetUsed() > highWater)
+    highWater = GetUsed();
+  return block;
+}
+
+void Arena::Reset() {
+  if (!overflow.empty()) {
+    for (void *block : overflow) {
+      std::free(block);
+    }
+    overflow.clear();
+
+    // Grow once so the next cycle of the same size fits in the buffer
+    size_t grown = capacity * 2 > highWater ? capacity * 2 : highWater;
+    char *larger = static_cast<char *>(std::malloc(grown));
+    if (larger) {
+      std::free(buffer);
+      buffer = larger;
+      capacity = grown;
+    }
+  }
+  offset = 0;
+  overflowBytes = 0;
+}
+
+NodePool::~NodePool() {
+  for (char *batch : batches) {
+    std::free(batch);
+  }
+}
+
+void *NodePool::Take(size_t bytes) {
+  if (blockBytes == 0) {
+    blockBytes = bytes; // PoolAllocator only asks for more than a pointer
+  }
+  if (bytes != blockBytes) {
+    return nullptr;
+  }
+  if (!head) {
+    const size_t count = std::max(blockCount, (size_t)64);
+    char *batch = static_cast<char *>(std::malloc(count * blockBytes));
+    if (!batch) {
+      throw std::bad_alloc();
+    }
+    batches.push_back(batch);
+    for (size_t i = count; i-- > 0;) {
+      head = new (batch + i * blockBytes) FreeBlock{head};
+    }
+    blockCount += count;
+  }
+  FreeBlock *block = head;
+  head = block->next;
+  return block;
+}
+
+bool NodePool::Give(void *block, size_t bytes) {
+  if (bytes != blockBytes) {
+    return false;
+  }
+  head = new (block) FreeBlock{head};
+  return true;
+}
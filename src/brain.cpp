@@ -0,0 +1,196 @@
+#include "brain.h"
+#include "constants.h"
+#include "raylib.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace BrainLayout;
+
+const int BrainBatch::LANES;
+
+// Rational approximation of tanh, exact enough for steering and cheap to
+// vectorize; std::tanh would keep the batch loops scalar
+static inline float FastTanh(float x) {
+  x = std::min(std::max(x, -3.0f), 3.0f); // Exactly +-1 from here on
+  float x2 = x * x;
+  return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+}
+
+static float RandomWeight(float range) {
+  return (float)GetRandomValue(-1000, 1000) / 1000.0f * range;
+}
+
+Genome Genome::Random() {
+  Genome genome;
+  for (int i = 0; i < WEIGHT_COUNT; i++) {
+    genome.weights[i] = RandomWeight(1.0f);
+  }
+  return genome;
+}
+
+Genome Genome::Inherit(const Genome &a, const Genome &b,
+                       RandomStream &random) {
+  Genome child;
+  for (int i = 0; i < WEIGHT_COUNT; i++) {
+    child.weights[i] = random.Range(0, 1) ? a.weights[i] : b.weights[i];
+    if (random.Range(0, 999) < Constants::BRAIN_MUTATION_RATE * 1000) {
+      child.weights[i] += (float)random.Range(-1000, 1000) / 1000.0f *
+                          Constants::BRAIN_MUTATION_SCALE;
+    }
+  }
+  return child;
+}
+
+BrainOutput Genome::Evaluate(const BrainInput &input) const {
+  float hidden[HIDDEN_COUNT];
+  for (int h = 0; h < HIDDEN_COUNT; h++) {
+    float sum = 0.0f;
+    for (int i = 0; i < INPUT_COUNT; i++) {
+      sum += weights[h * INPUT_COUNT + i] * input.values[i];
+    }
+    hidden[h] = FastTanh(sum);
+  }
+
+  BrainOutput output;
+  for (int o = 0; o < OUTPUT_COUNT; o++) {
+    const float *row = &weights[HIDDEN_WEIGHTS + o * (HIDDEN_COUNT + 1)];
+    float sum = row[HIDDEN_COUNT];
+    for (int h = 0; h < HIDDEN_COUNT; h++) {
+      sum += row[h] * hidden[h];
+    }
+    output.values[o] = FastTanh(sum);
+  }
+  return output;
+}
+
+void BrainBatch::Clear() {
+  blocks.clear();
+  count = 0;
+}
+
+void BrainBatch::Add(const Genome &genome) {
+  Resize(count + 1);
+  Set(count - 1, genome);
+}
+
+void BrainBatch::Resize(uint32_t newCount) {
+  // New blocks are value-initialized, so every lane starts at zero
+  size_t blockCount = (newCount + LANES - 1) / LANES;
+  if (blockCount > blocks.size()) {
+    blocks.resize(blockCount);
+  }
+  count = std::max(count, newCount);
+}
+
+void BrainBatch::Set(uint32_t index, const Genome &genome) {
+  Block &block = blocks[index / LANES];
+  int lane = index % LANES;
+  for (int w = 0; w < WEIGHT_COUNT; w++) {
+    block.weights[w][lane] = genome.weights[w];
+  }
+}
+
+Genome BrainBatch::GetGenome(uint32_t index) const {
+  const Block &block = blocks[index / LANES];
+  int lane = index % LANES;
+  Genome genome;
+  for (int w = 0; w < WEIGHT_COUNT; w++) {
+    genome.weights[w] = block.weights[w][lane];
+  }
+  return genome;
+}
+
+void BrainBatch::Reorder(const uint32_t *order) {
+  reordered.resize(blocks.size());
+  if (!blocks.empty()) {
+    std::memset(reordered.data(), 0, blocks.size() * sizeof(Block));
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    const Block &from = blocks[order[i] / LANES];
+    Block &to = reordered[i / LANES];
+    int fromLane = order[i] % LANES;
+    int toLane = i % LANES;
+    for (int w = 0; w < WEIGHT_COUNT; w++) {
+      to.weights[w][toLane] = from.weights[w][fromLane];
+    }
+  }
+  blocks.swap(reordered);
+}
+
+void BrainBatch::Remove(uint32_t index) {
+  uint32_t last = count - 1;
+  Block &lastBlock = blocks[last / LANES];
+  int lastLane = last % LANES;
+  if (index != last) {
+    Block &block = blocks[index / LANES];
+    int lane = index % LANES;
+    for (int w = 0; w < WEIGHT_COUNT; w++) {
+      block.weights[w][lane] = lastBlock.weights[w][lastLane];
+    }
+  }
+
+  // Unused lanes keep zero weights so they evaluate to harmless zeros
+  for (int w = 0; w < WEIGHT_COUNT; w++) {
+    lastBlock.weights[w][lastLane] = 0.0f;
+  }
+  count--;
+  if (count % LANES == 0) {
+    blocks.pop_back();
+  }
+}
+
+void BrainBatch::SetInput(uint32_t index, const BrainInput &input) {
+  Block &block = blocks[index / LANES];
+  int lane = index % LANES;
+  for (int i = 0; i < INPUT_COUNT; i++) {
+    block.inputs[i][lane] = input.values[i];
+  }
+}
+
+void BrainBatch::Evaluate() {
+  // The same arithmetic as Genome::Evaluate, with every step done for all
+  // lanes of a block at once
+  for (Block &block : blocks) {
+    float hidden[HIDDEN_COUNT][LANES];
+    for (int h = 0; h < HIDDEN_COUNT; h++) {
+      float sum[LANES] = {};
+      for (int i = 0; i < INPUT_COUNT; i++) {
+        const float *weight = block.weights[h * INPUT_COUNT + i];
+        const float *input = block.inputs[i];
+        for (int lane = 0; lane < LANES; lane++) {
+          sum[lane] += weight[lane] * input[lane];
+        }
+      }
+      for (int lane = 0; lane < LANES; lane++) {
+        hidden[h][lane] = FastTanh(sum[lane]);
+      }
+    }
+
+    for (int o = 0; o < OUTPUT_COUNT; o++) {
+      int row = HIDDEN_WEIGHTS + o * (HIDDEN_COUNT + 1);
+      float sum[LANES];
+      for (int lane = 0; lane < LANES; lane++) {
+        sum[lane] = block.weights[row + HIDDEN_COUNT][lane];
+      }
+      for (int h = 0; h < HIDDEN_COUNT; h++) {
+        const float *weight = block.weights[row + h];
+        for (int lane = 0; lane < LANES; lane++) {
+          sum[lane] += weight[lane] * hidden[h][lane];
+        }
+      }
+      for (int lane = 0; lane < LANES; lane++) {
+        block.outputs[o][lane] = FastTanh(sum[lane]);
+      }
+    }
+  }
+}
+
+BrainOutput BrainBatch::GetOutput(uint32_t index) const {
+  const Block &block = blocks[index / LANES];
+  int lane = index % LANES;
+  BrainOutput output;
+  for (int o = 0; o < OUTPUT_COUNT; o++) {
+    output.values[o] = block.outputs[o][lane];
+  }
+  return output;
+}
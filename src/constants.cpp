@@ -0,0 +1,68 @@
+#include "constants.h"
+
+// Defaults; Scenario::Load overwrites them before the world is built
+namespace Constants {
+// Creature traits
+float INITIAL_HEALTH = 100.0f;
+float INITIAL_ENERGY = 100.0f;
+float MIN_STRENGTH = 40.0f;
+float MAX_STRENGTH = 100.0f;
+float MIN_SPEED = 0.5f;
+float MAX_SPEED = 1.2f;
+float MIN_METABOLISM = 0.5f;
+float MAX_METABOLISM = 1.5f;
+
+// State thresholds
+float HUNGRY_THRESHOLD = 50.0f;
+float CRITICAL_HEALTH = 30.0f;
+float LOW_HEALTH = 70.0f;
+float MATING_ENERGY = 50.0f;
+float MATING_AGE = 5.0f;
+
+// State timers (simulation seconds)
+float EATING_DURATION = 0.1f;
+float MATING_COOLDOWN = 1.0f;
+float FIGHT_COOLDOWN = 0.5f;
+float SICK_RECOVERY_TIME = 2.0f;
+float SICK_RECOVERY_HEALTH = 10.0f;
+
+// Movement
+float BASE_MOVEMENT_SPEED = 30.0f;
+float MAX_VELOCITY = 2.0f;
+float BOUNDARY_BOUNCE = -1.f;
+float FOOD_SEEK_FORCE = 0.5f;
+
+// Energy & Health
+float ENERGY_CONSUMPTION_RATE = 10.f;
+float HEALTH_DECAY_RATE = 20.0f;
+float FOOD_ENERGY_VALUE = 100.0f;
+
+// Simulation
+float FOOD_SPAWN_INTERVAL = 1.f;
+int FOOD_SPAWN_COUNT = 5;
+int INITIAL_CREATURE_COUNT = 100;
+int INITIAL_FOOD_COUNT = 0;
+float INITIAL_CREATURE_SIZE = 10.0f;
+float FOOD_GROW_SIZE = 0.5f;
+
+// Food field (--food-field); densities are in units of one food item
+float FIELD_CAPACITY = 0.05f;
+float FIELD_REGROWTH_RATE = 0.1f;
+float FIELD_SEED_RATE = 0.00001f;
+float FIELD_DIFFUSION = 0.5f;
+float FIELD_UPDATE_INTERVAL = 0.1f;
+float FIELD_BITE_RATE = 1.0f;
+float FIELD_SCENT_RADIUS = 40.0f;
+float FIELD_FOOD_THRESHOLD = 0.005f;
+
+// Perception
+float PERCEPTION_RANGE = 250.0f;
+float PERCEPTION_FOV = 240.0f;
+float TOUCH_RADIUS_SCALE = 3.0f;
+
+// Brains
+float BRAIN_STEER_FORCE = 0.5f;
+float BRAIN_AGE_SCALE = 60.0f;
+float BRAIN_MUTATION_RATE = 0.1f;
+float BRAIN_MUTATION_SCALE = 0.3f;
+} // namespace Constants
@@ -1,21 +1,74 @@
 #include "creature.h"
 #include "constants.h"
+#include "lineage.h"
 #include "names.h"
+#include "perception.h"
+#include "wire.h"
+#include "world.h"
+#include <algorithm>
 #include <cmath>
+#include <utility>
+
+uint32_t Creature::nextId = 0;
+uint32_t Creature::idLimit = 0xFFFFFFFFu; // Lineage::NONE is never an id
+
+uint32_t Creature::TakeIds(uint32_t count) {
+  if (count > idLimit - nextId) {
+    TraceLog(LOG_FATAL, "CREATURE: Out of ids, %u left of the range",
+             idLimit - nextId);
+  }
+  uint32_t first = nextId;
+  nextId += count;
+  return first;
+}
 
 Creature::Creature(Vector2 pos, float size)
-    : position(pos), velocity({0, 0}), rotation(0.0f), size(size),
+    : Creature(pos, size, GetRandomValue(0, 1) == 1) {
+  strength = GetRandomValue(Constants::MIN_STRENGTH, Constants::MAX_STRENGTH);
+  speed = (float)GetRandomValue(Constants::MIN_SPEED * 100,
+                                Constants::MAX_SPEED * 100) /
+          100.0f;
+  metabolism = (float)GetRandomValue(Constants::MIN_METABOLISM * 100,
+                                     Constants::MAX_METABOLISM * 100) /
+               100.0f;
+}
+
+Creature::Creature(Vector2 pos, float size, bool isMale)
+    : id(TakeIds(1)), position(pos), velocity(Vector2{0, 0}), size(size),
       health(Constants::INITIAL_HEALTH), energy(Constants::INITIAL_ENERGY),
-      age(0), state(CreatureState::WANDERING), color(GREEN),
-      name(Names::generate_name()), isMale(GetRandomValue(0, 1) == 1),
-      strength(
-          GetRandomValue(Constants::MIN_STRENGTH, Constants::MAX_STRENGTH)),
-      speed((float)GetRandomValue(Constants::MIN_SPEED * 100,
-                                  Constants::MAX_SPEED * 100) /
-            100.0f),
-      metabolism((float)GetRandomValue(Constants::MIN_METABOLISM * 100,
-                                       Constants::MAX_METABOLISM * 100) /
-                 100.0f) {}
+      age(0), state(CreatureState::WANDERING), isMale(isMale) {
+#ifndef CREATURE_COMPACT
+  rotation = 0.0f;
+  color = GREEN;
+  nameCode = Names::NextCode();
+#endif
+}
+
+Creature Creature::Founder(uint32_t id, uint64_t nameCode, Vector2 pos,
+                           float size, bool isMale, float strength,
+                           float speed, float metabolism) {
+  Creature creature;
+  creature.id = id;
+  creature.position = pos;
+  creature.velocity = Vector2{0, 0};
+  creature.size = size;
+  creature.health = Constants::INITIAL_HEALTH;
+  creature.energy = Constants::INITIAL_ENERGY;
+  creature.age = 0;
+  creature.state = CreatureState::WANDERING;
+  creature.isMale = isMale;
+  creature.strength = strength;
+  creature.speed = speed;
+  creature.metabolism = metabolism;
+#ifndef CREATURE_COMPACT
+  creature.rotation = 0.0f;
+  creature.color = GREEN;
+  creature.nameCode = nameCode;
+#else
+  (void)nameCode;
+#endif
+  return creature;
+}
 
 float Clamp(float value, float min, float max) {
   if (value < min)
@@ -25,196 +78,248 @@ float Clamp(float value, float min, float max) {
   return value;
 }
 
-void Creature::Update(float deltaTime, const std::vector<Creature> &others,
-                      std::vector<Food> &foods,
-                      std::vector<Creature> &allCreatures) {
+void Creature::UpdateVitals(float deltaTime) {
   age += deltaTime;
-  energy -= deltaTime * Constants::ENERGY_CONSUMPTION_RATE * metabolism;
+  float burnRate = Constants::ENERGY_CONSUMPTION_RATE * metabolism;
+  float before = energy;
+  energy -= deltaTime * burnRate;
 
+  // Only the part of the step spent with no energy left costs health, so
+  // one long step matches many short ones
   if (energy < 0) {
-    health -= deltaTime * Constants::HEALTH_DECAY_RATE;
+    float starving = before > 0 ? -energy / burnRate : deltaTime;
+    health -= starving * Constants::HEALTH_DECAY_RATE;
   }
+}
 
-  // Try to eat if hungry
-  if (state == CreatureState::HUNTING || state == CreatureState::EATING) {
-    bool foundFood = false;
-    Vector2 nearestFoodPos = {0, 0};
-    float nearestDist = INFINITY;
-
-    // Find nearest food
-    for (auto &food : foods) {
-      if (!food.IsConsumed()) {
-        Vector2 foodPos = food.GetPosition();
-        float dx = position.x - foodPos.x;
-        float dy = position.y - foodPos.y;
-        float distance = sqrt(dx * dx + dy * dy);
-
-        if (distance < nearestDist) {
-          nearestDist = distance;
-          nearestFoodPos = foodPos;
-          foundFood = true;
-        }
+float Creature::Resume(float deltaTime) {
+  float total = deferredTime + deltaTime;
+  deferredTime = 0.0f;
+  return total;
+}
+
+BrainInput Creature::Sense(const Senses &senses) const {
+  using namespace BrainLayout;
+  const float range = Constants::PERCEPTION_RANGE;
+  BrainInput input = {};
+
+  // Nearest food and creature relative to the facing direction, scaled so
+  // that the edge of the sensing range has length 1
+  if (senses.foodCount > 0) {
+    const SensedObject &food = senses.foods[0];
+    input.values[FOOD_AHEAD] = cosf(food.bearing) * food.distance / range;
+    input.values[FOOD_SIDE] = sinf(food.bearing) * food.distance / range;
+  } else if (senses.foodScent.x != 0.0f || senses.foodScent.y != 0.0f) {
+    // The field's scent reads as food one sampling radius uphill
+    float bearing = atan2f(senses.foodScent.y, senses.foodScent.x) -
+                    GetRotation() * DEG2RAD;
+    float distance = Constants::FIELD_SCENT_RADIUS / range;
+    input.values[FOOD_AHEAD] = cosf(bearing) * distance;
+    input.values[FOOD_SIDE] = sinf(bearing) * distance;
+  }
+  if (senses.creatureCount > 0) {
+    const SensedObject &other = senses.creatures[0];
+    input.values[CREATURE_AHEAD] = cosf(other.bearing) * other.distance / range;
+    input.values[CREATURE_SIDE] = sinf(other.bearing) * other.distance / range;
+  }
 
-        // Check if we're close enough to eat
-        if (distance < (size + Food::SIZE) * 0.5f) {
-          food.Consume();
-          energy += Constants::FOOD_ENERGY_VALUE;
-          if (energy > Constants::INITIAL_ENERGY) {
-            energy = Constants::INITIAL_ENERGY;
-          }
-
-          // Grow in size when eating
-          size += Constants::FOOD_GROW_SIZE;
-
-          // Adjust speed and strength based on size
-          speed =
-              Clamp(speed * 0.95f, Constants::MIN_SPEED, Constants::MAX_SPEED);
-          strength = Clamp(strength * 1.05f, Constants::MIN_STRENGTH,
-                           Constants::MAX_STRENGTH);
-
-          state = CreatureState::EATING;
-          // Stop moving while eating
-          velocity = {0, 0};
+  input.values[ENERGY] = energy / Constants::INITIAL_ENERGY;
+  input.values[HEALTH] = health / Constants::INITIAL_HEALTH;
+  input.values[AGE] = std::min(age / Constants::BRAIN_AGE_SCALE, 1.0f);
+  input.values[BIAS] = 1.0f;
+  return input;
+}
+
+void Creature::Eat(World &world) {
+  energy += Constants::FOOD_ENERGY_VALUE;
+  if (energy > Constants::INITIAL_ENERGY) {
+    energy = Constants::INITIAL_ENERGY;
+  }
+  TraitSample before = GetTraits();
+
+  // Grow in size when eating
+  size += Constants::FOOD_GROW_SIZE;
+
+  // Adjust speed and strength based on size
+  speed = Clamp(speed * 0.95f, Constants::MIN_SPEED, Constants::MAX_SPEED);
+  strength = Clamp(strength * 1.05f, Constants::MIN_STRENGTH,
+                   Constants::MAX_STRENGTH);
+  world.traitStats.Replace(before, GetTraits());
+
+  if (state != CreatureState::EATING) {
+    StartTimer(TimerKind::EATING_DONE, Constants::EATING_DURATION, world);
+  }
+  state = CreatureState::EATING;
+  // Stop moving while eating
+  velocity = {0, 0};
+}
+
+template <bool FIELD>
+void Creature::UpdateFeeding(World &world, const Senses &senses,
+                             float deltaTime) {
+  if (FIELD) {
+    Graze(world, senses, deltaTime);
+    return;
+  }
+  bool foundFood = false;
+  Vector2 nearestFoodPos = {0, 0};
+
+  // Perceived food comes nearest first; some may have been eaten already
+  // this tick
+  for (int i = 0; i < senses.foodCount; i++) {
+    Food &food = world.foods[senses.foods[i].index];
+    if (!food.IsConsumed()) {
+      float distance = senses.foods[i].distance;
+      if (!foundFood) {
+        nearestFoodPos = food.GetPosition();
+        foundFood = true;
+      }
+
+      // Check if we're close enough to eat
+      if (distance < (size + Food::SIZE) * 0.5f) {
+        if (food.IsGhost()) {
+          // Its owner decides whether this creature gets it
+          world.foodClaims.push_back(
+              FoodClaim{id, food.GetPosition(), distance});
           break;
         }
+        food.Consume();
+        Eat(world);
+        break;
       }
     }
+  }
+
+  // Move towards nearest food if hunting, or wherever the brain steers
+  const BrainOutput *thoughts = ThoughtsIn(world);
+  if (state == CreatureState::HUNTING && thoughts) {
+    Steer(*thoughts);
+  } else if (state == CreatureState::HUNTING && foundFood) {
+    float dx = nearestFoodPos.x - position.x;
+    float dy = nearestFoodPos.y - position.y;
+    float dist = sqrt(dx * dx + dy * dy);
+    if (dist > 0) {
+      velocity.x += (dx / dist) * Constants::FOOD_SEEK_FORCE;
+      velocity.y += (dy / dist) * Constants::FOOD_SEEK_FORCE;
+    }
+  } else if (state == CreatureState::HUNTING) {
+    // Search until food comes into view
+    Wander(world.RandomFor(id, RandomPurpose::SEARCH), world);
+  }
+}
 
-    // Move towards nearest food if hunting
-    if (state == CreatureState::HUNTING && foundFood) {
-      float dx = nearestFoodPos.x - position.x;
-      float dy = nearestFoodPos.y - position.y;
-      float dist = sqrt(dx * dx + dy * dy);
-      if (dist > 0) {
-        velocity.x += (dx / dist) * Constants::FOOD_SEEK_FORCE;
-        velocity.y += (dy / dist) * Constants::FOOD_SEEK_FORCE;
-      }
+void Creature::Graze(World &world, const Senses &senses, float deltaTime) {
+  // Eat what the cell underfoot holds, growing in proportion, and otherwise
+  // follow the scent uphill
+  float eaten =
+      world.foodField.Eat(position, Constants::FIELD_BITE_RATE * deltaTime);
+  if (eaten > 0.0f) {
+    energy = std::min(energy + eaten * Constants::FOOD_ENERGY_VALUE,
+                      Constants::INITIAL_ENERGY);
+    TraitSample before = GetTraits();
+    size += Constants::FOOD_GROW_SIZE * eaten;
+    speed = Clamp(speed * powf(0.95f, eaten), Constants::MIN_SPEED,
+                  Constants::MAX_SPEED);
+    strength = Clamp(strength * powf(1.05f, eaten), Constants::MIN_STRENGTH,
+                     Constants::MAX_STRENGTH);
+    world.traitStats.Replace(before, GetTraits());
+  }
+
+  // A bite worth stopping for keeps the creature eating
+  if (eaten >= Constants::FIELD_FOOD_THRESHOLD * 0.1f) {
+    if (state != CreatureState::EATING) {
+      StartTimer(TimerKind::EATING_DONE, Constants::EATING_DURATION, world);
     }
+    state = CreatureState::EATING;
+    velocity = {0, 0};
+    return;
   }
 
-  UpdateState(others, foods, allCreatures); // Pass foods to UpdateState
-  UpdateMovement(deltaTime, others);
-  UpdateColor();
+  if (state != CreatureState::HUNTING) {
+    return;
+  }
+  float scent = sqrtf(senses.foodScent.x * senses.foodScent.x +
+                      senses.foodScent.y * senses.foodScent.y);
+  const BrainOutput *thoughts = ThoughtsIn(world);
+  if (thoughts) {
+    Steer(*thoughts);
+  } else if (scent > 0.0f) {
+    velocity.x += senses.foodScent.x / scent * Constants::FOOD_SEEK_FORCE;
+    velocity.y += senses.foodScent.y / scent * Constants::FOOD_SEEK_FORCE;
+  } else {
+    Wander(world.RandomFor(id, RandomPurpose::SEARCH), world);
+  }
 }
 
-void Creature::UpdateState(const std::vector<Creature> &others,
-                           std::vector<Food> &foods,
-                           std::vector<Creature> &allCreatures) {
-  timeSinceLastFight += GetFrameTime();
+template <bool FIGHTING, bool FIELD>
+int Creature::UpdateState(World &world, const Senses &senses,
+                          Interaction *proposals, bool &fellSick) {
+  CreatureState previousState = state;
+  int proposed = 0;
 
   // Priority-based state machine
   if (state == CreatureState::EATING) {
-    // Stay in eating state for a very short duration
-    static float eatTimer = 0;
-    eatTimer += GetFrameTime();
-    if (eatTimer > 0.1f) { // Reduced from 1.0f to 0.2f
-      eatTimer = 0;
-      state = CreatureState::WANDERING;
-    }
+    // Stay in eating state until the EATING_DONE timer fires
   } else if (energy < Constants::HUNGRY_THRESHOLD) {
     // Hunting is highest priority when hungry
     bool foundFood = false;
 
-    // First, check for available food
-    for (const auto &food : foods) {
-      if (!food.IsConsumed()) {
-        foundFood = true;
-        break;
+    // First, check for food in the field nearby, or in sight
+    if (FIELD) {
+      foundFood = world.foodField.Sample(position) >
+                      Constants::FIELD_FOOD_THRESHOLD ||
+                  senses.foodScent.x != 0.0f || senses.foodScent.y != 0.0f;
+    } else {
+      for (int i = 0; i < senses.foodCount; i++) {
+        if (!world.foods[senses.foods[i].index].IsConsumed()) {
+          foundFood = true;
+          break;
+        }
       }
     }
 
     // If no food, look for creatures eating
-    if (!foundFood) {
-      for (const auto &other : others) {
-        if (&other != this && other.state == CreatureState::EATING) {
-          Vector2 otherPos = other.GetPosition();
-          float dx = position.x - otherPos.x;
-          float dy = position.y - otherPos.y;
-          float dist = sqrt(dx * dx + dy * dy);
-
-          if (dist < size * 2) { // Close enough to fight
-            if (GetFightProbability(other) > 0.5f) {
-              state = CreatureState::FIGHTING;
-              Fight(const_cast<Creature &>(other));
-
-              // If fight is won, simulate getting the food energy
-              if (energy < 0) {
-                energy += Constants::FOOD_ENERGY_VALUE * 0.8f;
-              }
-
-              break;
-            }
-          }
+    if (FIGHTING && !foundFood && canFight &&
+        Wants(BrainLayout::FIGHT, world)) {
+      for (int i = 0; i < senses.creatureCount &&
+                      proposed < InteractionStage::MAX_PROPOSALS;
+           i++) {
+        const Creature &other = world.creatures[senses.creatures[i].index];
+        float dist = senses.creatures[i].distance;
+        if (other.state == CreatureState::EATING &&
+            dist < size * 2 && // Close enough to fight
+            GetFightProbability(other, world) > 0.5f) {
+          proposals[proposed++] = {InteractionKind::FIGHT_OVER_FOOD,
+                                   senses.creatures[i].index, dist};
         }
       }
     }
 
-    // If no successful fight, continue hunting
-    if (state != CreatureState::FIGHTING) {
-      state = CreatureState::HUNTING;
-    }
+    // Keep hunting unless the interaction stage settles a fight
+    state = CreatureState::HUNTING;
   } else if (health < Constants::CRITICAL_HEALTH) {
     // Very low health is an emergency
     state = CreatureState::SICK;
-  } else if (energy > Constants::MATING_ENERGY && age > Constants::MATING_AGE) {
+  } else if (canMate && Wants(BrainLayout::MATE, world) &&
+             energy > Constants::MATING_ENERGY &&
+             age > Constants::MATING_AGE) {
     // Check for nearby potential mates and competition
-    for (const auto &other : others) {
-      if (&other != this && other.GetEnergy() > Constants::MATING_ENERGY &&
+    for (int i = 0; i < senses.creatureCount &&
+                    proposed < InteractionStage::MAX_PROPOSALS;
+         i++) {
+      const Creature &other = world.creatures[senses.creatures[i].index];
+      float dist = senses.creatures[i].distance;
+      if (other.GetEnergy() > Constants::MATING_ENERGY &&
           other.GetAge() > Constants::MATING_AGE &&
-          other.IsMale() != isMale) { // Must be opposite sex
-
-        Vector2 otherPos = other.GetPosition();
-        float dx = position.x - otherPos.x;
-        float dy = position.y - otherPos.y;
-        float dist = sqrt(dx * dx + dy * dy);
-
-        if (dist < size * 3) { // Close enough to compete
-          // If another male is nearby, fight for mating rights
-          if (!isMale && other.IsMale()) {
-            if (GetFightProbability(other) > 0.5f) {
-              state = CreatureState::FIGHTING;
-              Fight(const_cast<Creature &>(other));
-              break;
-            }
-          }
-
-          // Proceed with mating if no fight occurs
-          if (state != CreatureState::FIGHTING) {
-            Vector2 newPos = {(position.x + otherPos.x) / 2,
-                              (position.y + otherPos.y) / 2};
-
-            // Mix parents' traits with some variation
-            float mixStrength = (strength + other.GetStrength()) / 2;
-            float mixSpeed = (speed + other.GetSpeed()) / 2;
-            float mixMetabolism = (metabolism + other.GetMetabolism()) / 2;
-
-            // Add some random variation (-10% to +10%)
-            mixStrength *= (1.0f + (GetRandomValue(-10, 10) / 100.0f));
-            mixSpeed *= (1.0f + (GetRandomValue(-10, 10) / 100.0f));
-            mixMetabolism *= (1.0f + (GetRandomValue(-10, 10) / 100.0f));
-
-            // Clamp values
-            mixStrength = Clamp(mixStrength, Constants::MIN_STRENGTH,
-                                Constants::MAX_STRENGTH);
-            mixSpeed = Clamp(mixSpeed + 0.1f, Constants::MIN_SPEED,
-                             Constants::MAX_SPEED);
-            mixMetabolism = Clamp(mixMetabolism, Constants::MIN_METABOLISM,
-                                  Constants::MAX_METABOLISM);
-
-            // Create new creature
-            allCreatures.emplace_back(newPos, size);
-            auto &child = allCreatures.back();
-            child.strength = mixStrength;
-            child.speed = mixSpeed;
-            child.metabolism = mixMetabolism;
-
-            // Reset energy after reproduction
-            energy *= 0.7f; // Cost of reproduction
-
-            state = CreatureState::MATING;
-            break;
-          }
-        }
+          other.IsMale() != isMale && // Must be opposite sex
+          dist < size * 3) {          // Close enough to compete
+        // If another male is nearby, fight for mating rights
+        bool fight = FIGHTING && !isMale && other.IsMale() && canFight &&
+                     Wants(BrainLayout::FIGHT, world) &&
+                     GetFightProbability(other, world) > 0.5f;
+        proposals[proposed++] = {fight ? InteractionKind::FIGHT_OVER_MATE
+                                       : InteractionKind::MATE,
+                                 senses.creatures[i].index, dist};
       }
     }
   } else if (health < Constants::LOW_HEALTH) {
@@ -224,44 +329,163 @@ void Creature::UpdateState(const std::vector<Creature> &others,
     state = CreatureState::WANDERING;
   }
 
-  // Implement contagion for sick creatures
-  if (state == CreatureState::SICK) {
-    for (auto &other : const_cast<std::vector<Creature> &>(others)) {
-      if (&other != this) {
-        Vector2 otherPos = other.GetPosition();
-        float dx = position.x - otherPos.x;
-        float dy = position.y - otherPos.y;
-        float dist = sqrt(dx * dx + dy * dy);
-
-        // If close enough, chance of spreading sickness
-        if (dist < size * 2) {
-          if (GetRandomValue(0, 100) < 10) { // 10% chance of infection
-            other.health -= 5.0f;            // Reduce health
-            if (other.health < Constants::CRITICAL_HEALTH) {
-              other.state = CreatureState::SICK;
-            }
-          }
-        }
-      }
+  fellSick =
+      state == CreatureState::SICK && previousState != CreatureState::SICK;
+  return proposed;
+}
+
+// The kernels World::Step picks between
+template void Creature::UpdateFeeding<false>(World &, const Senses &, float);
+template void Creature::UpdateFeeding<true>(World &, const Senses &, float);
+template int Creature::UpdateState<false, false>(World &, const Senses &,
+                                                 Interaction *, bool &);
+template int Creature::UpdateState<false, true>(World &, const Senses &,
+                                                Interaction *, bool &);
+template int Creature::UpdateState<true, false>(World &, const Senses &,
+                                                Interaction *, bool &);
+template int Creature::UpdateState<true, true>(World &, const Senses &,
+                                               Interaction *, bool &);
+
+bool Creature::Interact(InteractionKind kind, Creature &other, World &world) {
+  if (kind != InteractionKind::MATE) {
+    // Determine fight outcome based on strength
+    RandomStream random = world.RandomFor(id, RandomPurpose::INTERACTION);
+    float fightProbability = GetFightProbability(other, world);
+    bool won = random.Range(0, 100) / 100.0f < fightProbability;
+    if (!ghost) {
+      TakeOutcome(kind, won, world);
     }
+    other.TakeFightResult(!won);
+    return won;
+  }
+
+  // In brain mode the child inherits both parents' genomes, found by id. A
+  // parent missing from the index has no genome to hand down, so there is
+  // no child rather than one with some other creature's brain.
+  auto parentA = world.indexById.find(id);
+  auto parentB = world.indexById.find(other.id);
+  if (world.brainsEnabled &&
+      (parentA == world.indexById.end() || parentB == world.indexById.end())) {
+    TraceLog(LOG_WARNING, "CREATURE: No genome for #%u or #%u to inherit",
+             id, other.id);
+    return false;
+  }
+
+  Vector2 otherPos = other.GetPosition();
+  Vector2 newPos = {(position.x + otherPos.x) / 2,
+                    (position.y + otherPos.y) / 2};
+
+  // Mix parents' traits with some variation
+  float mixStrength = (strength + other.GetStrength()) / 2;
+  float mixSpeed = (speed + other.GetSpeed()) / 2;
+  float mixMetabolism = (metabolism + other.GetMetabolism()) / 2;
+
+  // Add some random variation (-10% to +10%)
+  RandomStream random = world.RandomFor(id, RandomPurpose::INTERACTION);
+  mixStrength *= (1.0f + (random.Range(-10, 10) / 100.0f));
+  mixSpeed *= (1.0f + (random.Range(-10, 10) / 100.0f));
+  mixMetabolism *= (1.0f + (random.Range(-10, 10) / 100.0f));
+
+  // Clamp values
+  mixStrength =
+      Clamp(mixStrength, Constants::MIN_STRENGTH, Constants::MAX_STRENGTH);
+  mixSpeed =
+      Clamp(mixSpeed + 0.1f, Constants::MIN_SPEED, Constants::MAX_SPEED);
+  mixMetabolism = Clamp(mixMetabolism, Constants::MIN_METABOLISM,
+                        Constants::MAX_METABOLISM);
+
+  // Create new creature
+  world.births.push_back(Creature(newPos, size, random.Range(0, 1) == 1));
+  world.birthParents.push_back(std::make_pair(id, other.id));
+  auto &child = world.births.back();
+  child.strength = mixStrength;
+  child.speed = mixSpeed;
+  child.metabolism = mixMetabolism;
+  if (world.brainsEnabled) {
+    world.birthGenomes.push_back(
+        Genome::Inherit(world.brains.GetGenome(parentA->second),
+                        world.brains.GetGenome(parentB->second), random));
+  }
+
+  if (!ghost) {
+    TakeOutcome(kind, true, world);
   }
+  return true;
 }
 
-void Creature::UpdateMovement(float deltaTime,
-                              const std::vector<Creature> &others) {
-  // Don't move while eating, fighting, or mating
-  if (state == CreatureState::EATING || state == CreatureState::FIGHTING ||
-      state == CreatureState::MATING) {
-    velocity = {0, 0};
+void Creature::TakeOutcome(InteractionKind kind, bool won, World &world) {
+  if (kind != InteractionKind::MATE) {
+    state = CreatureState::FIGHTING;
+    TakeFightResult(won);
+    StartTimer(TimerKind::FIGHT_COOLDOWN, Constants::FIGHT_COOLDOWN, world);
+
+    // If fight is won, simulate getting the food energy
+    if (kind == InteractionKind::FIGHT_OVER_FOOD && energy < 0) {
+      energy += Constants::FOOD_ENERGY_VALUE * 0.8f;
+    }
     return;
   }
 
-  // Normal random movement
-  if (state != CreatureState::HUNTING) {
-    velocity.x += (float)GetRandomValue(-20, 20) / 100.0f;
-    velocity.y += (float)GetRandomValue(-20, 20) / 100.0f;
+  // Reset energy after reproduction
+  energy *= 0.7f; // Cost of reproduction
+
+  state = CreatureState::MATING;
+  StartTimer(TimerKind::MATING_COOLDOWN, Constants::MATING_COOLDOWN, world);
+}
+
+void Creature::SpreadSickness(World &world,
+                              const std::vector<SensedObject> &nearby) {
+  // Every creature close enough has a chance of catching it
+  for (const SensedObject &sensed : nearby) {
+    Creature &other = world.creatures[sensed.index];
+    RandomStream random =
+        world.RandomFor(id, RandomPurpose::CONTAGION, other.GetId());
+    if (random.Range(0, 100) < 10) { // 10% chance of infection
+      if (other.IsGhost()) {
+        world.ghostInfections.push_back(other.GetId()); // Its owner's call
+      } else {
+        other.Infect(world);
+      }
+    }
   }
+}
+
+void Creature::StartRecovery(World &world) {
+  StartTimer(TimerKind::SICK_RECOVERY, Constants::SICK_RECOVERY_TIME, world);
+}
+
+void Creature::Infect(World &world) {
+  health -= 5.0f; // Reduce health
+  if (health < Constants::CRITICAL_HEALTH && state != CreatureState::SICK) {
+    state = CreatureState::SICK;
+    StartRecovery(world);
+  }
+}
+
+void Creature::Halt() { velocity = {0, 0}; }
 
+void Creature::Wander(RandomStream random, const World &world) {
+  const BrainOutput *thoughts = ThoughtsIn(world);
+  if (thoughts) {
+    Steer(*thoughts);
+    return;
+  }
+  velocity.x += (float)random.Range(-20, 20) / 100.0f;
+  velocity.y += (float)random.Range(-20, 20) / 100.0f;
+}
+
+void Creature::Steer(const BrainOutput &thoughts) {
+  // Brain outputs are relative to the facing direction
+  float radians = GetRotation() * DEG2RAD;
+  float ahead = thoughts.values[BrainLayout::STEER_AHEAD];
+  float side = thoughts.values[BrainLayout::STEER_SIDE];
+  velocity.x += (ahead * cosf(radians) - side * sinf(radians)) *
+                Constants::BRAIN_STEER_FORCE;
+  velocity.y += (ahead * sinf(radians) + side * cosf(radians)) *
+                Constants::BRAIN_STEER_FORCE;
+}
+
+void Creature::Move(float deltaTime) {
   // Limit velocity
   float speed = sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
   if (speed > Constants::MAX_VELOCITY) {
@@ -269,35 +493,182 @@ void Creature::UpdateMovement(float deltaTime,
     velocity.y = (velocity.y / speed) * Constants::MAX_VELOCITY;
   }
 
-  // Update position
-  position.x += velocity.x * deltaTime * Constants::BASE_MOVEMENT_SPEED * speed;
-  position.y += velocity.y * deltaTime * Constants::BASE_MOVEMENT_SPEED * speed;
+  // Update position. The bounds are checked before storing, since a
+  // compact position saturates rather than going negative.
+  Vector2 next = position;
+  next.x += velocity.x * deltaTime * Constants::BASE_MOVEMENT_SPEED * speed;
+  next.y += velocity.y * deltaTime * Constants::BASE_MOVEMENT_SPEED * speed;
 
+#ifndef CREATURE_COMPACT
   // Update rotation to face movement direction
   if (speed > 0.1f) { // Only update rotation if moving significantly
     rotation = atan2f(velocity.y, velocity.x) * RAD2DEG;
   }
+#endif
 
   // Bounce off boundaries
-  if (position.x < 0) {
-    position.x = 0;
+  if (next.x < 0) {
+    next.x = 0;
     velocity.x *= Constants::BOUNDARY_BOUNCE;
   }
-  if (position.x > GetScreenWidth() - size) {
-    position.x = GetScreenWidth() - size;
+  if (next.x > GetScreenWidth() - size) {
+    next.x = GetScreenWidth() - size;
     velocity.x *= -0.8f;
   }
-  if (position.y < 0) {
-    position.y = 0;
+  if (next.y < 0) {
+    next.y = 0;
     velocity.y *= -0.8f;
   }
-  if (position.y > GetScreenHeight() - size) {
-    position.y = GetScreenHeight() - size;
+  if (next.y > GetScreenHeight() - size) {
+    next.y = GetScreenHeight() - size;
     velocity.y *= -0.8f;
   }
+  position = next;
+}
+
+void Creature::UpdateColor() {
+#ifndef CREATURE_COMPACT
+  color = GetStateColor();
+#endif
 }
 
-void Creature::UpdateColor() { color = GetStateColor(); }
+#ifdef CREATURE_COMPACT
+std::string Creature::GetName() const { return Names::FromId(id); }
+#else
+std::string Creature::GetName() const { return Names::Spell(nameCode); }
+#endif
+
+uint32_t Creature::IndexIn(const World &world) const {
+  return (uint32_t)(this - world.creatures.data());
+}
+
+CreatureTimers &Creature::TimersIn(World &world) const {
+  return world.creatureTimers[IndexIn(world)];
+}
+
+const BrainOutput *Creature::ThoughtsIn(const World &world) const {
+  return world.thoughts ? &world.thoughts[IndexIn(world)] : nullptr;
+}
+
+void Creature::StartTimer(TimerKind kind, float seconds, World &world) {
+  // A new token supersedes any timer of this kind that is still pending
+  CreatureTimers &timers = TimersIn(world);
+  uint32_t token = ++timers.tokens[(int)kind];
+  timers.due[(int)kind] =
+      world.ScheduleTimer(TimerEvent{id, token, kind}, seconds);
+
+  if (kind == TimerKind::MATING_COOLDOWN) {
+    canMate = false;
+  } else if (kind == TimerKind::FIGHT_COOLDOWN) {
+    canFight = false;
+  }
+}
+
+void Creature::OnTimer(const TimerEvent &event, World &world) {
+  CreatureTimers &timers = TimersIn(world);
+  if (event.token != timers.tokens[(int)event.kind]) {
+    return;
+  }
+  timers.due[(int)event.kind] = 0;
+
+  switch (event.kind) {
+  case TimerKind::EATING_DONE:
+    if (state == CreatureState::EATING) {
+      state = CreatureState::WANDERING;
+      UpdateColor();
+    }
+    break;
+  case TimerKind::MATING_COOLDOWN:
+    canMate = true;
+    break;
+  case TimerKind::FIGHT_COOLDOWN:
+    canFight = true;
+    break;
+  case TimerKind::SICK_RECOVERY:
+    // Recover a little for every full recovery period spent sick
+    if (state == CreatureState::SICK) {
+      health = std::min(health + Constants::SICK_RECOVERY_HEALTH,
+                        Constants::INITIAL_HEALTH);
+      StartTimer(TimerKind::SICK_RECOVERY, Constants::SICK_RECOVERY_TIME,
+                 world);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+void Creature::Write(std::vector<uint8_t> &out) const {
+  using Wire::Put;
+  Put(out, id);
+  Put(out, canMate);
+  Put(out, canFight);
+  Put(out, deferredTime);
+  Put(out, position);
+  Put(out, velocity);
+#ifndef CREATURE_COMPACT
+  Put(out, rotation);
+#endif
+  Put(out, size);
+  Put(out, health);
+  Put(out, energy);
+  Put(out, age);
+  Put(out, (uint8_t)state);
+#ifndef CREATURE_COMPACT
+  Put(out, color);
+  Put(out, nameCode);
+#endif
+  Put(out, isMale);
+  Put(out, strength);
+  Put(out, speed);
+  Put(out, metabolism);
+}
+
+bool Creature::Read(const uint8_t *&cursor, const uint8_t *end,
+                    Creature &creature) {
+  using Wire::Get;
+  uint8_t state;
+  bool ok = Get(cursor, end, creature.id) &&
+            Get(cursor, end, creature.canMate) &&
+            Get(cursor, end, creature.canFight) &&
+            Get(cursor, end, creature.deferredTime) &&
+            Get(cursor, end, creature.position) &&
+            Get(cursor, end, creature.velocity) &&
+#ifndef CREATURE_COMPACT
+            Get(cursor, end, creature.rotation) &&
+#endif
+            Get(cursor, end, creature.size) &&
+            Get(cursor, end, creature.health) &&
+            Get(cursor, end, creature.energy) &&
+            Get(cursor, end, creature.age) && Get(cursor, end, state);
+#ifndef CREATURE_COMPACT
+  ok = ok && Get(cursor, end, creature.color) &&
+       Get(cursor, end, creature.nameCode);
+#endif
+  if (!ok || state >= (uint8_t)CreatureState::COUNT) {
+    return false;
+  }
+  creature.state = (CreatureState)state;
+  creature.selected = false;
+  creature.ghost = false;
+  return Get(cursor, end, creature.isMale) &&
+         Get(cursor, end, creature.strength) &&
+         Get(cursor, end, creature.speed) &&
+         Get(cursor, end, creature.metabolism);
+}
+
+void Creature::Rearm(World &world) {
+  // Fresh tokens, so that nothing scheduled for this id before it left can
+  // fire for it now
+  CreatureTimers &timers = TimersIn(world);
+  for (int kind = 0; kind < (int)TimerKind::COUNT; kind++) {
+    if (timers.due[kind] != 0) {
+      uint32_t token = ++timers.tokens[kind];
+      world.ScheduleTimerAt(TimerEvent{id, token, (TimerKind)kind},
+                            timers.due[kind]);
+    }
+  }
+}
 
 Color Creature::GetStateColor() const {
   switch (state) {
@@ -318,40 +689,28 @@ Color Creature::GetStateColor() const {
   }
 }
 
-void Creature::Fight(Creature &opponent) {
-  // Determine fight outcome based on strength
-  float fightProbability = GetFightProbability(opponent);
-
-  if (GetRandomValue(0, 100) / 100.0f < fightProbability) {
+void Creature::TakeFightResult(bool won) {
+  if (won) {
     // Winner gets energy and health boost
     energy += 10.0f;
     health += 5.0f;
-
-    // Loser loses energy and health
-    opponent.energy -= 15.0f;
-    opponent.health -= 10.0f;
   } else {
-    // Loser scenario
+    // Loser loses energy and health
     energy -= 15.0f;
     health -= 10.0f;
-
-    // Winner gets energy and health boost
-    opponent.energy += 10.0f;
-    opponent.health += 5.0f;
   }
-
-  // Reset fight timer
-  timeSinceLastFight = 0.0f;
-  lastFightOpponent = &opponent;
 }
 
-float Creature::GetFightProbability(const Creature &opponent) const {
+float Creature::GetFightProbability(const Creature &opponent,
+                                    const World &world) const {
   // Calculate fight probability based on strength difference
   float strengthDiff = strength - opponent.strength;
   float baseProbability = 0.5f + (strengthDiff / (Constants::MAX_STRENGTH * 2));
 
-  // Add some randomness
-  baseProbability += (GetRandomValue(-10, 10) / 100.0f);
+  // Add some randomness, the same however often the pair is sized up
+  RandomStream random =
+      world.RandomFor(id, RandomPurpose::FIGHT_ODDS, opponent.id);
+  baseProbability += (random.Range(-10, 10) / 100.0f);
 
   // Clamp probability between 0 and 1
   return Clamp(baseProbability, 0.0f, 1.0f);
@@ -384,6 +743,9 @@ void Creature::Draw(int rank, const std::vector<Creature> &allCreatures) const {
   }
 
   // Determine color based on selection state
+#ifdef CREATURE_COMPACT
+  Color color = GetStateColor();
+#endif
   Color baseColor = color;
   Color nameColor = WHITE;
   Color statusColor = LIGHTGRAY;
@@ -399,13 +761,13 @@ void Creature::Draw(int rank, const std::vector<Creature> &allCreatures) const {
     nameColor = ColorAlpha(WHITE, 0.3f);
     statusColor = ColorAlpha(LIGHTGRAY, 0.2f);
   }
-  DrawText(TextFormat("#%d %s", rank, name.c_str()), position.x - size,
+  DrawText(TextFormat("#%d %s", rank, GetName().c_str()), position.x - size,
            position.y - size - 40, 10, nameColor);
-  DrawText(TextFormat("[%.1fs]\n(%s)", age, stateText), position.x - size,
-           position.y - size - 30, 8, statusColor);
+  DrawText(TextFormat("[%.1fs]\n(%s)", (float)age, stateText),
+           position.x - size, position.y - size - 30, 8, statusColor);
 
   // Draw creature body
-  DrawPoly(position, isMale ? 3 : 6, size, rotation + 90.0f, baseColor);
+  DrawPoly(position, isMale ? 3 : 6, size, GetRotation() + 90.0f, baseColor);
 
   // Draw health bar background and bar
   DrawRectangle(
@@ -414,7 +776,7 @@ void Creature::Draw(int rank, const std::vector<Creature> &allCreatures) const {
   DrawRectangle(
       position.x - size, position.y - size - 10, size * 2 * (health / 100.0f),
       4, ColorAlpha(RED, anyCreatureSelected && !selected ? 0.4f : 0.8f));
-  DrawText(TextFormat("H:%.0f", health), position.x - size - 35,
+  DrawText(TextFormat("H:%.0f", (float)health), position.x - size - 35,
            position.y - size - 10, 6,
            ColorAlpha(RED, anyCreatureSelected && !selected ? 0.2f : 0.8f));
 
@@ -425,13 +787,13 @@ void Creature::Draw(int rank, const std::vector<Creature> &allCreatures) const {
   DrawRectangle(
       position.x - size, position.y - size - 6, size * 2 * (energy / 100.0f), 4,
       ColorAlpha(YELLOW, anyCreatureSelected && !selected ? 0.4f : 0.8f));
-  DrawText(TextFormat("E:%.0f", energy), position.x + size * 2 - 2,
+  DrawText(TextFormat("E:%.0f", (float)energy), position.x + size * 2 - 2,
            position.y - size - 10, 6,
            ColorAlpha(YELLOW, anyCreatureSelected && !selected ? 0.2f : 0.8f));
 
   // Draw strength indicator (outline thickness)
   DrawPolyLines(
-      position, isMale ? 3 : 6, size, rotation + 90.0f,
+      position, isMale ? 3 : 6, size, GetRotation() + 90.0f,
       ColorAlpha(WHITE, selected ? strength / 100.0f : strength / 300.0f));
 
   // Draw selection indicator
@@ -439,13 +801,13 @@ void Creature::Draw(int rank, const std::vector<Creature> &allCreatures) const {
     DrawCircleLines(position.x, position.y, size * 1.5f, WHITE);
 
     // Draw attributes in smaller text with colors
-    DrawText(TextFormat("st:%.0f", strength), position.x - size,
+    DrawText(TextFormat("st:%.0f", (float)strength), position.x - size,
              position.y + size + 2, 10, ORANGE);
-    DrawText(TextFormat("\nsp:%.1f", speed), position.x - size,
+    DrawText(TextFormat("\nsp:%.1f", (float)speed), position.x - size,
              position.y + size + 12, 10, SKYBLUE);
-    DrawText(TextFormat("\n\nmt:%.1f", metabolism), position.x - size,
+    DrawText(TextFormat("\n\nmt:%.1f", (float)metabolism), position.x - size,
              position.y + size + 22, 10, GREEN);
-    DrawText(TextFormat("\n\n\nsize:%.1f", size), position.x - size,
+    DrawText(TextFormat("\n\n\nsize:%.1f", (float)size), position.x - size,
              position.y + size + 32, 10, PURPLE);
   }
 }
@@ -0,0 +1,165 @@
+#include "differential.h"
+#include "constants.h"
+#include "world.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace {
+const char *const STATE_NAMES[(int)CreatureState::COUNT] = {
+    "wandering", "hunting", "mating", "fighting", "eating", "sick",
+};
+const size_t REPORTED_CREATURES = 5;
+
+// Appends " name reference/stepped" when the values are too far apart
+void CompareField(std::string &diff, const char *name, float reference,
+                  float stepped, float tolerance) {
+  if (std::fabs(reference - stepped) > tolerance) {
+    diff += TextFormat(" %s %.4f/%.4f", name, reference, stepped);
+  }
+}
+
+// The fields of one creature that differ between the engines, if any
+std::string Diff(const Creature &reference, const Creature &stepped,
+                 const DifferentialConfig &config) {
+  std::string diff;
+  if (reference.GetState() != stepped.GetState()) {
+    diff += TextFormat(" state %s/%s", STATE_NAMES[(int)reference.GetState()],
+                       STATE_NAMES[(int)stepped.GetState()]);
+  }
+  Vector2 a = reference.GetPosition();
+  Vector2 b = stepped.GetPosition();
+  if (hypotf(a.x - b.x, a.y - b.y) > config.positionTolerance) {
+    diff += TextFormat(" position (%.3f, %.3f)/(%.3f, %.3f)", a.x, a.y, b.x,
+                       b.y);
+  }
+  CompareField(diff, "energy", reference.GetEnergy(), stepped.GetEnergy(),
+               config.vitalsTolerance);
+  CompareField(diff, "health", reference.GetHealth(), stepped.GetHealth(),
+               config.vitalsTolerance);
+  CompareField(diff, "strength", reference.GetStrength(),
+               stepped.GetStrength(), config.traitTolerance);
+  CompareField(diff, "speed", reference.GetSpeed(), stepped.GetSpeed(),
+               config.traitTolerance);
+  CompareField(diff, "metabolism", reference.GetMetabolism(),
+               stepped.GetMetabolism(), config.traitTolerance);
+  CompareField(diff, "size", reference.GetSize(), stepped.GetSize(),
+               config.traitTolerance);
+  return diff;
+}
+} // namespace
+
+bool Differential::Run() {
+  ticksCompared = 0;
+  report.clear();
+
+  SetRandomSeed(config.seed);
+  World stepped;
+  World reference;
+  stepped.brainsEnabled = config.brains;
+  reference.brainsEnabled = config.brains;
+  stepped.contagionEnabled = config.contagion;
+  reference.contagionEnabled = config.contagion;
+  stepped.fightingEnabled = config.fighting;
+  reference.fightingEnabled = config.fighting;
+  stepped.multiRate = config.multiRate;
+  reference.multiRate = config.multiRate;
+  stepped.focusRegion = config.focusRegion;
+  reference.focusRegion = config.focusRegion;
+  if (config.foodField) {
+    stepped.foodField.Reset((float)GetScreenWidth(), (float)GetScreenHeight());
+  }
+  stepped.seed = config.seed;
+  for (int i = 0; i < config.creatureCount; i++) {
+    stepped.SpawnCreature({(float)GetRandomValue(0, GetScreenWidth()),
+                           (float)GetRandomValue(0, GetScreenHeight())},
+                          Constants::INITIAL_CREATURE_SIZE);
+  }
+  std::vector<uint8_t> state;
+  stepped.Save(state);
+  if (!reference.Load(state.data(), state.size())) {
+    report = "Could not copy the world into the reference engine";
+    return false;
+  }
+
+  for (uint64_t tick = 0; tick < config.ticks && !stepped.creatures.empty();
+       tick++) {
+    // The same food and new ids for both
+    const uint32_t nextId = Creature::GetNextId();
+    const unsigned tickSeed = config.seed ^ (unsigned)(tick * 2654435761u);
+    SetRandomSeed(tickSeed);
+    Tick(reference, true);
+    Creature::ReserveIds(nextId);
+    SetRandomSeed(tickSeed);
+    Tick(stepped, false);
+
+    ticksCompared++;
+    if (!Compare(reference, stepped)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Differential::Tick(World &world, bool reference) {
+  // Food arrives as in the interactive run
+  const float deltaTime = Constants::PHYSICS_TIMESTEP;
+  if (!world.foodField.IsEnabled()) {
+    world.foodSpawnTimer += deltaTime;
+  }
+  if (world.foodSpawnTimer >= Constants::FOOD_SPAWN_INTERVAL) {
+    for (int i = 0; i < Constants::FOOD_SPAWN_COUNT; i++) {
+      world.foods.emplace_back(
+          Vector2{(float)GetRandomValue(0, GetScreenWidth()),
+                  (float)GetRandomValue(0, GetScreenHeight())});
+    }
+    world.foodSpawnTimer = 0;
+  }
+  if (reference) {
+    world.StepReference(deltaTime);
+  } else {
+    world.Step(deltaTime);
+  }
+}
+
+bool Differential::Compare(const World &reference, const World &stepped) {
+  std::vector<std::pair<uint32_t, std::string>> diffs; // By creature id
+  for (const auto &creature : stepped.creatures) {
+    auto it = reference.indexById.find(creature.GetId());
+    std::string diff =
+        it == reference.indexById.end()
+            ? std::string(" only stepped")
+            : Diff(reference.creatures[it->second], creature, config);
+    if (!diff.empty()) {
+      diffs.emplace_back(creature.GetId(), diff);
+    }
+  }
+  for (const auto &creature : reference.creatures) {
+    if (stepped.indexById.find(creature.GetId()) ==
+        stepped.indexById.end()) {
+      diffs.emplace_back(creature.GetId(), " only in reference");
+    }
+  }
+
+  const int population = (int)stepped.creatures.size();
+  if (diffs.empty()) {
+    return true;
+  }
+
+  // The first few creatures in id order, with only the fields that differ
+  std::sort(diffs.begin(), diffs.end());
+  report = TextFormat("Diverged on tick %llu: %d creatures differ, "
+                      "population %d reference/%d stepped",
+                      (unsigned long long)stepped.tickCount, (int)diffs.size(),
+                      (int)reference.creatures.size(), population);
+  for (size_t i = 0; i < std::min(diffs.size(), REPORTED_CREATURES); i++) {
+    report += TextFormat("\n  #%u", diffs[i].first);
+    report += diffs[i].second;
+  }
+  if (diffs.size() > REPORTED_CREATURES) {
+    report += TextFormat("\n  and %d more",
+                         (int)(diffs.size() - REPORTED_CREATURES));
+  }
+  return false;
+}
@@ -0,0 +1,558 @@
+#include "domain.h"
+#include "constants.h"
+#include "wire.h"
+#include "world.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+using Wire::Get;
+using Wire::Put;
+
+int TileLayout::TileAt(Vector2 position) const {
+  int column = (int)(position.x / worldWidth * columns);
+  int row = (int)(position.y / worldHeight * rows);
+  column = std::min(std::max(column, 0), columns - 1);
+  row = std::min(std::max(row, 0), rows - 1);
+  return row * columns + column;
+}
+
+Rectangle TileLayout::GetBounds(int tile) const {
+  float width = worldWidth / columns;
+  float height = worldHeight / rows;
+  return Rectangle{(tile % columns) * width, (tile / columns) * height, width,
+                   height};
+}
+
+std::vector<int> TileLayout::GetNeighbours(int tile) const {
+  std::vector<int> neighbours;
+  int column = tile % columns;
+  int row = tile / columns;
+  for (int y = std::max(row - 1, 0); y <= std::min(row + 1, rows - 1); y++) {
+    for (int x = std::max(column - 1, 0);
+         x <= std::min(column + 1, columns - 1); x++) {
+      if (x != column || y != row) {
+        neighbours.push_back(y * columns + x);
+      }
+    }
+  }
+  return neighbours;
+}
+
+std::vector<std::vector<int>>
+SocketTransport::Connect(const TileLayout &layout) {
+  int count = layout.GetCount();
+  std::vector<std::vector<int>> links(count, std::vector<int>(count, -1));
+  for (int a = 0; a < count; a++) {
+    for (int b : layout.GetNeighbours(a)) {
+      int pair[2];
+      if (b > a && socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0) {
+        links[a][b] = pair[0];
+        links[b][a] = pair[1];
+      }
+    }
+  }
+  return links;
+}
+
+SocketTransport::SocketTransport(const std::vector<int> &sockets)
+    : sockets(sockets) {
+  for (int fd : sockets) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+  }
+}
+
+SocketTransport::~SocketTransport() {
+  for (int fd : sockets) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+bool SocketTransport::Exchange(
+    const std::vector<std::vector<uint8_t>> &outgoing,
+    std::vector<std::vector<uint8_t>> &incoming) {
+  // Every link sends and receives at once, so that two neighbours writing
+  // large messages to each other cannot both block on full buffers
+  struct Link {
+    uint32_t sendLength;
+    size_t sent = 0;
+    uint32_t receiveLength = 0;
+    size_t received = 0;
+  };
+  const size_t HEADER = sizeof(uint32_t);
+  size_t count = sockets.size();
+  std::vector<Link> links(count);
+  incoming.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    links[i].sendLength = (uint32_t)outgoing[i].size();
+    incoming[i].clear();
+  }
+
+  auto sendDone = [&](size_t i) {
+    return links[i].sent == HEADER + links[i].sendLength;
+  };
+  auto receiveDone = [&](size_t i) {
+    return links[i].received >= HEADER &&
+           links[i].received == HEADER + links[i].receiveLength;
+  };
+
+  std::vector<pollfd> polls(count);
+  while (true) {
+    bool pending = false;
+    for (size_t i = 0; i < count; i++) {
+      polls[i].fd = sockets[i];
+      polls[i].events = (short)((sendDone(i) ? 0 : POLLOUT) |
+                                (receiveDone(i) ? 0 : POLLIN));
+      polls[i].revents = 0;
+      pending = pending || polls[i].events != 0;
+    }
+    if (!pending) {
+      return true;
+    }
+    if (poll(polls.data(), (nfds_t)count, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+      Link &link = links[i];
+      // Hang-ups are reported even on links that are done for this round
+      if (!sendDone(i) && (polls[i].revents & (POLLOUT | POLLERR))) {
+        const uint8_t *data;
+        size_t size;
+        if (link.sent < HEADER) {
+          data = (const uint8_t *)&link.sendLength + link.sent;
+          size = HEADER - link.sent;
+        } else {
+          data = outgoing[i].data() + (link.sent - HEADER);
+          size = link.sendLength - (link.sent - HEADER);
+        }
+        ssize_t sent = send(sockets[i], data, size, SEND_FLAGS);
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+            errno != EINTR) {
+          return false;
+        }
+        link.sent += sent > 0 ? (size_t)sent : 0;
+      }
+
+      if (!receiveDone(i) &&
+          (polls[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+        uint8_t *data;
+        size_t size;
+        if (link.received < HEADER) {
+          data = (uint8_t *)&link.receiveLength + link.received;
+          size = HEADER - link.received;
+        } else {
+          data = incoming[i].data() + (link.received - HEADER);
+          size = link.receiveLength - (link.received - HEADER);
+        }
+        ssize_t received = recv(sockets[i], data, size, 0);
+        if (received == 0) {
+          return false; // The neighbour has exited
+        }
+        if (received < 0) {
+          if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return false;
+          }
+          continue;
+        }
+        link.received += (size_t)received;
+        if (link.received == HEADER) {
+          incoming[i].resize(link.receiveLength);
+        }
+      }
+    }
+  }
+}
+
+DomainNode::DomainNode(const TileLayout &layout, int tile,
+                       Transport &transport, World &world)
+    : layout(layout), tile(tile), transport(transport), world(world),
+      neighbours(layout.GetNeighbours(tile)) {
+  const float range = Constants::PERCEPTION_RANGE;
+  for (int neighbour : neighbours) {
+    Rectangle bounds = layout.GetBounds(neighbour);
+    halos.push_back(Rectangle{bounds.x - range, bounds.y - range,
+                              bounds.width + range * 2,
+                              bounds.height + range * 2});
+  }
+  outboxes.resize(neighbours.size());
+  outgoing.resize(neighbours.size());
+}
+
+bool DomainNode::Step(float deltaTime) {
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    Encode((int)n, outgoing[n]);
+  }
+  if (!transport.Exchange(outgoing, incoming)) {
+    return false;
+  }
+  ghostOwners.clear();
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    if (!Decode((int)n, incoming[n])) {
+      return false;
+    }
+  }
+
+  connected = true;
+  world.claimExchange = this;
+  world.Step(deltaTime);
+  world.claimExchange = nullptr;
+  if (!connected) {
+    return false;
+  }
+  world.RemoveGhosts();
+  ReleaseMigrants();
+  return true;
+}
+
+bool DomainNode::Trade() {
+  connected = connected && transport.Exchange(outgoing, incoming);
+  return connected;
+}
+
+void DomainNode::SettleFood(World &) {
+  // Round 1: u32 count, {u32 claimant, f32 x, f32 y, f32 distance}
+  for (const FoodClaim &claim : world.foodClaims) {
+    outboxes[NeighbourToward(layout.TileAt(claim.position))]
+        .foodClaims.push_back(claim);
+  }
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    Outbox &box = outboxes[n];
+    outgoing[n].clear();
+    Put(outgoing[n], (uint32_t)box.foodClaims.size());
+    for (const FoodClaim &claim : box.foodClaims) {
+      Put(outgoing[n], claim.claimantId);
+      Put(outgoing[n], claim.position);
+      Put(outgoing[n], claim.distance);
+    }
+    box.foodClaims.clear();
+  }
+  if (!Trade()) {
+    return;
+  }
+
+  struct Taker {
+    FoodClaim claim;
+    int neighbour;
+  };
+  std::vector<Taker> takers;
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    const uint8_t *cursor = incoming[n].data();
+    const uint8_t *end = cursor + incoming[n].size();
+    uint32_t count;
+    connected = Get(cursor, end, count);
+    for (uint32_t i = 0; connected && i < count; i++) {
+      Taker taker;
+      taker.neighbour = (int)n;
+      connected = Get(cursor, end, taker.claim.claimantId) &&
+                  Get(cursor, end, taker.claim.position) &&
+                  Get(cursor, end, taker.claim.distance);
+      takers.push_back(taker);
+    }
+    if (!connected || cursor != end) {
+      connected = false;
+      return;
+    }
+  }
+
+  // Local creatures have eaten already; of the rest, the nearest gets it.
+  // Food never moves, so its position identifies it.
+  std::sort(takers.begin(), takers.end(), [](const Taker &x, const Taker &y) {
+    if (x.claim.distance != y.claim.distance) {
+      return x.claim.distance < y.claim.distance;
+    }
+    return x.claim.claimantId < y.claim.claimantId;
+  });
+  for (const Taker &taker : takers) {
+    for (auto &food : world.foods) {
+      if (!food.IsGhost() && !food.IsConsumed() &&
+          food.GetPosition().x == taker.claim.position.x &&
+          food.GetPosition().y == taker.claim.position.y) {
+        food.Consume();
+        outboxes[taker.neighbour].fed.push_back(taker.claim.claimantId);
+        break;
+      }
+    }
+  }
+
+  // Round 2: u32 count, {u32 claimant}
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    Outbox &box = outboxes[n];
+    outgoing[n].clear();
+    Put(outgoing[n], (uint32_t)box.fed.size());
+    for (uint32_t id : box.fed) {
+      Put(outgoing[n], id);
+    }
+    box.fed.clear();
+  }
+  if (!Trade()) {
+    return;
+  }
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    const uint8_t *cursor = incoming[n].data();
+    const uint8_t *end = cursor + incoming[n].size();
+    uint32_t count;
+    connected = Get(cursor, end, count);
+    for (uint32_t i = 0; connected && i < count; i++) {
+      uint32_t id;
+      connected = Get(cursor, end, id);
+      Creature *claimant = connected ? world.Find(id) : nullptr;
+      if (claimant && !claimant->IsGhost()) {
+        claimant->Eat(world);
+      }
+    }
+    if (!connected || cursor != end) {
+      connected = false;
+      return;
+    }
+  }
+}
+
+void DomainNode::SettleClaims(World &) {
+  // u32 count, {u32 proposer, u32 partner, u8 kind, f32 distance}
+  for (const InteractionClaim &claim : world.interactions.GetClaims()) {
+    outboxes[ghostOwners[claim.partnerId]].claims.push_back(claim);
+  }
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    Outbox &box = outboxes[n];
+    outgoing[n].clear();
+    Put(outgoing[n], (uint32_t)box.claims.size());
+    for (const InteractionClaim &claim : box.claims) {
+      Put(outgoing[n], claim.proposerId);
+      Put(outgoing[n], claim.partnerId);
+      Put(outgoing[n], (uint8_t)claim.kind);
+      Put(outgoing[n], claim.distance);
+    }
+    box.claims.clear();
+  }
+  if (!Trade()) {
+    return;
+  }
+
+  std::vector<InteractionClaim> claims;
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    const uint8_t *cursor = incoming[n].data();
+    const uint8_t *end = cursor + incoming[n].size();
+    uint32_t count;
+    connected = Get(cursor, end, count);
+    for (uint32_t i = 0; connected && i < count; i++) {
+      InteractionClaim claim;
+      uint8_t kind = 0;
+      connected = Get(cursor, end, claim.proposerId) &&
+                  Get(cursor, end, claim.partnerId) &&
+                  Get(cursor, end, kind) && Get(cursor, end, claim.distance);
+      claim.kind = (InteractionKind)kind;
+      claims.push_back(claim);
+    }
+    if (!connected || cursor != end) {
+      connected = false;
+      return;
+    }
+  }
+  world.interactions.Accept(world, claims);
+}
+
+void DomainNode::SettleOutcomes(World &) {
+  //   u32 count, {u32 proposer, u8 kind, u8 won}
+  //   u32 count, {u32 infected}
+  for (const InteractionOutcome &outcome : world.interactions.GetOutcomes()) {
+    outboxes[ghostOwners[outcome.proposerId]].outcomes.push_back(outcome);
+  }
+  for (uint32_t id : world.ghostInfections) {
+    outboxes[ghostOwners[id]].infections.push_back(id);
+  }
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    Outbox &box = outboxes[n];
+    outgoing[n].clear();
+    Put(outgoing[n], (uint32_t)box.outcomes.size());
+    for (const InteractionOutcome &outcome : box.outcomes) {
+      Put(outgoing[n], outcome.proposerId);
+      Put(outgoing[n], (uint8_t)outcome.kind);
+      Put(outgoing[n], (uint8_t)outcome.won);
+    }
+    Put(outgoing[n], (uint32_t)box.infections.size());
+    for (uint32_t id : box.infections) {
+      Put(outgoing[n], id);
+    }
+    box.outcomes.clear();
+    box.infections.clear();
+  }
+  if (!Trade()) {
+    return;
+  }
+
+  // Interactions come before contagion, as in a single world
+  std::vector<uint32_t> infected;
+  for (size_t n = 0; n < neighbours.size(); n++) {
+    const uint8_t *cursor = incoming[n].data();
+    const uint8_t *end = cursor + incoming[n].size();
+    uint32_t count;
+    connected = Get(cursor, end, count);
+    for (uint32_t i = 0; connected && i < count; i++) {
+      uint32_t id;
+      uint8_t kind = 0;
+      uint8_t won = 0;
+      connected = Get(cursor, end, id) && Get(cursor, end, kind) &&
+                  Get(cursor, end, won);
+      Creature *proposer = connected ? world.Find(id) : nullptr;
+      if (proposer && !proposer->IsGhost()) {
+        proposer->TakeOutcome((InteractionKind)kind, won != 0, world);
+      }
+    }
+    connected = connected && Get(cursor, end, count);
+    for (uint32_t i = 0; connected && i < count; i++) {
+      uint32_t id;
+      connected = Get(cursor, end, id);
+      infected.push_back(id);
+    }
+    if (!connected || cursor != end) {
+      connected = false;
+      return;
+    }
+  }
+  for (uint32_t id : infected) {
+    Creature *creature = world.Find(id);
+    if (creature && !creature->IsGhost()) {
+      creature->Infect(world);
+    }
+  }
+}
+
+int DomainNode::NeighbourToward(int target) const {
+  // One tile at a time; a creature fast enough to skip a tile is passed on
+  int column = tile % layout.columns;
+  int row = tile / layout.columns;
+  int targetColumn = target % layout.columns;
+  int targetRow = target / layout.columns;
+  column += (targetColumn > column) - (targetColumn < column);
+  row += (targetRow > row) - (targetRow < row);
+  auto it = std::find(neighbours.begin(), neighbours.end(),
+                      row * layout.columns + column);
+  return (int)(it - neighbours.begin());
+}
+
+void DomainNode::Encode(int neighbour, std::vector<uint8_t> &out) {
+  // Message layout, in order:
+  //   u32 count, {creature record, u32 parent ids[2], i32 generation,
+  //               bool founder}     creatures moving to the receiver
+  //   u32 count, creature records   ghosts for the receiver
+  //   u32 count, {f32 x, f32 y}      ghost food for the receiver
+  Outbox &box = outboxes[neighbour];
+  out.clear();
+  Put(out, box.migrantCount);
+  out.insert(out.end(), box.migrants.begin(), box.migrants.end());
+  box.migrants.clear();
+  box.migrantCount = 0;
+
+  const Rectangle &halo = halos[neighbour];
+  size_t countAt = out.size();
+  uint32_t count = 0;
+  Put(out, count);
+  for (uint32_t i = 0; i < world.creatures.size(); i++) {
+    if (CheckCollisionPointRec(world.creatures[i].GetPosition(), halo)) {
+      world.WriteCreature(i, out);
+      count++;
+    }
+  }
+  std::memcpy(&out[countAt], &count, sizeof(count));
+
+  countAt = out.size();
+  count = 0;
+  Put(out, count);
+  for (const auto &food : world.foods) {
+    if (!food.IsConsumed() &&
+        CheckCollisionPointRec(food.GetPosition(), halo)) {
+      Put(out, food.GetPosition());
+      count++;
+    }
+  }
+  std::memcpy(&out[countAt], &count, sizeof(count));
+}
+
+bool DomainNode::Decode(int neighbour, const std::vector<uint8_t> &message) {
+  const uint8_t *cursor = message.data();
+  const uint8_t *end = cursor + message.size();
+  uint32_t count;
+  Creature creature = Creature::Blank();
+  CreatureTimers timers;
+  Genome genome;
+
+  if (!Get(cursor, end, count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    Lineage::Placement placement;
+    int32_t generation;
+    if (!world.ReadCreature(cursor, end, creature, timers, genome) ||
+        !Get(cursor, end, placement.parents) ||
+        !Get(cursor, end, generation) ||
+        !Get(cursor, end, placement.founder)) {
+      return false;
+    }
+    placement.generation = generation;
+    world.Adopt(creature, timers, genome, placement);
+  }
+
+  if (!Get(cursor, end, count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    if (!world.ReadCreature(cursor, end, creature, timers, genome)) {
+      return false;
+    }
+    world.AddGhost(creature, genome);
+    ghostOwners[creature.GetId()] = neighbour;
+  }
+
+  if (!Get(cursor, end, count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    Vector2 position;
+    if (!Get(cursor, end, position)) {
+      return false;
+    }
+    world.AddGhostFood(position);
+  }
+  return cursor == end;
+}
+
+void DomainNode::ReleaseMigrants() {
+  for (uint32_t i = 0; i < world.creatures.size();) {
+    Vector2 position = world.creatures[i].GetPosition();
+    if (Owns(position)) {
+      i++;
+      continue;
+    }
+    int neighbour = NeighbourToward(layout.TileAt(position));
+    Outbox &box = outboxes[neighbour];
+    // Parents this tile's tree never had stay unknown from here on
+    Lineage::Placement placement =
+        world.lineage.GetPlacement(world.creatures[i].GetId());
+    world.WriteCreature(i, box.migrants);
+    Put(box.migrants, placement.parents);
+    Put(box.migrants, (int32_t)placement.generation);
+    Put(box.migrants, placement.founder);
+    world.Release(i);
+    box.migrantCount++;
+  }
+}
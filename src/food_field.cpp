@@ -0,0 +1,265 @@
+#include "food_field.h"
+#include "constants.h"
+#include "wire.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FIELD_SIMD 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FIELD_SIMD 1
+#else
+#define FIELD_SIMD 0
+#endif
+
+namespace {
+// Coefficients of one update, the same for every cell
+struct Stencil {
+  float diffusion; // Fraction exchanged with each neighbour
+  float growth;    // Regrowth rate times the time step
+  float inverseCapacity;
+  float seed;      // Added to every cell
+  float capacity;
+};
+
+float UpdateCell(const Stencil &k, float centre, float north, float south,
+                 float west, float east) {
+  float mixed =
+      centre + k.diffusion * (north + south + west + east - 4.0f * centre);
+  float grown = mixed + k.growth * centre * (1.0f - centre * k.inverseCapacity) +
+                k.seed;
+  return std::min(std::max(grown, 0.0f), k.capacity);
+}
+
+#if FIELD_SIMD
+#if defined(__SSE2__)
+typedef __m128 Lanes;
+inline Lanes Load(const float *p) { return _mm_loadu_ps(p); }
+inline void Store(float *p, Lanes v) { _mm_storeu_ps(p, v); }
+inline Lanes Splat(float v) { return _mm_set1_ps(v); }
+inline Lanes Add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes Sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+inline Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes Min(Lanes a, Lanes b) { return _mm_min_ps(a, b); }
+inline Lanes Max(Lanes a, Lanes b) { return _mm_max_ps(a, b); }
+#else
+typedef float32x4_t Lanes;
+inline Lanes Load(const float *p) { return vld1q_f32(p); }
+inline void Store(float *p, Lanes v) { vst1q_f32(p, v); }
+inline Lanes Splat(float v) { return vdupq_n_f32(v); }
+inline Lanes Add(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+inline Lanes Sub(Lanes a, Lanes b) { return vsubq_f32(a, b); }
+inline Lanes Mul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+inline Lanes Min(Lanes a, Lanes b) { return vminq_f32(a, b); }
+inline Lanes Max(Lanes a, Lanes b) { return vmaxq_f32(a, b); }
+#endif
+#endif
+
+// Updates cells [from, to) of one row, four at a time where possible. The
+// caller keeps x - 1 and x + 1 inside the row.
+void UpdateRow(const Stencil &k, const float *north, const float *row,
+               const float *south, float *out, int from, int to) {
+  int x = from;
+#if FIELD_SIMD
+  const Lanes diffusion = Splat(k.diffusion);
+  const Lanes growth = Splat(k.growth);
+  const Lanes inverseCapacity = Splat(k.inverseCapacity);
+  const Lanes seed = Splat(k.seed);
+  const Lanes capacity = Splat(k.capacity);
+  const Lanes one = Splat(1.0f);
+  const Lanes four = Splat(4.0f);
+  const Lanes zero = Splat(0.0f);
+  for (; x + 4 <= to; x += 4) {
+    Lanes centre = Load(row + x);
+    Lanes around = Add(Add(Load(north + x), Load(south + x)),
+                       Add(Load(row + x - 1), Load(row + x + 1)));
+    Lanes mixed =
+        Add(centre, Mul(diffusion, Sub(around, Mul(four, centre))));
+    Lanes headroom = Sub(one, Mul(centre, inverseCapacity));
+    Lanes grown = Add(Add(mixed, Mul(growth, Mul(centre, headroom))), seed);
+    Store(out + x, Min(Max(grown, zero), capacity));
+  }
+#endif
+  for (; x < to; x++) {
+    out[x] = UpdateCell(k, row[x], north[x], south[x], row[x - 1], row[x + 1]);
+  }
+}
+} // namespace
+
+FoodField::~FoodField() {
+  // Without a window the texture is already gone with the GL context
+  if (texture.id != 0 && IsWindowReady()) {
+    UnloadTexture(texture);
+  }
+}
+
+void FoodField::Reset(float width, float height) {
+  columns = std::max((int)std::ceil(width / Constants::FIELD_CELL_SIZE), 1);
+  rows = std::max((int)std::ceil(height / Constants::FIELD_CELL_SIZE), 1);
+  density.resize((size_t)columns * rows);
+  scratch.resize(density.size());
+  pendingTime = 0.0f;
+
+  // Random cells, which the first few updates blur into patches
+  for (float &cell : density) {
+    cell = Constants::FIELD_CAPACITY * GetRandomValue(0, 100) / 100.0f;
+  }
+  version++;
+}
+
+void FoodField::Advance(float deltaTime) {
+  pendingTime += deltaTime;
+  if (pendingTime >= Constants::FIELD_UPDATE_INTERVAL) {
+    Update(pendingTime);
+    pendingTime = 0.0f;
+  }
+}
+
+void FoodField::Update(float deltaTime) {
+  Stencil k;
+  // Explicit diffusion is only stable up to a quarter per neighbour
+  k.diffusion = std::min(Constants::FIELD_DIFFUSION * deltaTime, 0.25f);
+  k.growth = Constants::FIELD_REGROWTH_RATE * deltaTime;
+  k.inverseCapacity = 1.0f / Constants::FIELD_CAPACITY;
+  k.seed = Constants::FIELD_SEED_RATE * deltaTime;
+  k.capacity = Constants::FIELD_CAPACITY;
+
+  // Edges reflect, so nothing diffuses out of the world
+  for (int y = 0; y < rows; y++) {
+    const float *row = &density[(size_t)y * columns];
+    const float *north = y > 0 ? row - columns : row;
+    const float *south = y + 1 < rows ? row + columns : row;
+    float *out = &scratch[(size_t)y * columns];
+    if (columns == 1) {
+      out[0] = UpdateCell(k, row[0], north[0], south[0], row[0], row[0]);
+      continue;
+    }
+    out[0] = UpdateCell(k, row[0], north[0], south[0], row[0], row[1]);
+    UpdateRow(k, north, row, south, out, 1, columns - 1);
+    int last = columns - 1;
+    out[last] = UpdateCell(k, row[last], north[last], south[last],
+                           row[last - 1], row[last]);
+  }
+  density.swap(scratch);
+  version++;
+}
+
+float FoodField::At(int x, int y) const {
+  if (x < 0 || y < 0 || x >= columns || y >= rows) {
+    return 0.0f;
+  }
+  return density[(size_t)y * columns + x];
+}
+
+float FoodField::Sample(Vector2 position) const {
+  // Cell values sit at cell centres
+  float fx = position.x / Constants::FIELD_CELL_SIZE - 0.5f;
+  float fy = position.y / Constants::FIELD_CELL_SIZE - 0.5f;
+  int x = (int)std::floor(fx);
+  int y = (int)std::floor(fy);
+  float tx = fx - x;
+  float ty = fy - y;
+  float top = At(x, y) + (At(x + 1, y) - At(x, y)) * tx;
+  float bottom = At(x, y + 1) + (At(x + 1, y + 1) - At(x, y + 1)) * tx;
+  return top + (bottom - top) * ty;
+}
+
+Vector2 FoodField::GetGradient(Vector2 position) const {
+  const float r = Constants::FIELD_SCENT_RADIUS;
+  float dx = Sample({position.x + r, position.y}) -
+             Sample({position.x - r, position.y});
+  float dy = Sample({position.x, position.y + r}) -
+             Sample({position.x, position.y - r});
+  return {dx / (2.0f * r), dy / (2.0f * r)};
+}
+
+float FoodField::Eat(Vector2 position, float amount) {
+  int x = (int)(position.x / Constants::FIELD_CELL_SIZE);
+  int y = (int)(position.y / Constants::FIELD_CELL_SIZE);
+  if (x < 0 || y < 0 || x >= columns || y >= rows || amount <= 0.0f) {
+    return 0.0f;
+  }
+  float &cell = density[(size_t)y * columns + x];
+  float eaten = std::min(cell, amount);
+  cell -= eaten;
+  version++;
+  return eaten;
+}
+
+double FoodField::GetTotal() const {
+  double total = 0.0;
+  for (float cell : density) {
+    total += cell;
+  }
+  return total;
+}
+
+void FoodField::Draw() const {
+  if (!IsEnabled()) {
+    return;
+  }
+  if (textureVersion != version) {
+    pixels.resize(density.size() * 2);
+    for (size_t i = 0; i < density.size(); i++) {
+      pixels[i * 2] = 255;
+      pixels[i * 2 + 1] =
+          (uint8_t)(std::min(density[i] / Constants::FIELD_CAPACITY, 1.0f) *
+                    200.0f);
+    }
+    if (texture.id == 0 || texture.width != columns ||
+        texture.height != rows) {
+      if (texture.id != 0) {
+        UnloadTexture(texture);
+      }
+      Image image = {pixels.data(), columns, rows, 1,
+                     PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA};
+      texture = LoadTextureFromImage(image);
+      SetTextureFilter(texture, TEXTURE_FILTER_BILINEAR);
+    } else {
+      UpdateTexture(texture, pixels.data());
+    }
+    textureVersion = version;
+  }
+  const float size = Constants::FIELD_CELL_SIZE;
+  DrawTexturePro(texture, {0, 0, (float)columns, (float)rows},
+                 {0, 0, columns * size, rows * size}, {0, 0}, 0.0f,
+                 ColorAlpha(YELLOW, 0.8f));
+}
+
+void FoodField::Write(std::vector<uint8_t> &out) const {
+  using Wire::Put;
+  Put(out, (int32_t)columns);
+  Put(out, (int32_t)rows);
+  Put(out, pendingTime);
+  size_t at = out.size();
+  out.resize(at + density.size() * sizeof(float));
+  if (!density.empty()) {
+    std::memcpy(&out[at], density.data(), density.size() * sizeof(float));
+  }
+}
+
+bool FoodField::Read(const uint8_t *&cursor, const uint8_t *end) {
+  using Wire::Get;
+  int32_t newColumns, newRows;
+  if (!Get(cursor, end, newColumns) || !Get(cursor, end, newRows) ||
+      !Get(cursor, end, pendingTime) || newColumns < 0 || newRows < 0) {
+    return false;
+  }
+  size_t bytes = (size_t)newColumns * newRows * sizeof(float);
+  if ((size_t)(end - cursor) < bytes) {
+    return false;
+  }
+  columns = newColumns;
+  rows = newRows;
+  density.resize((size_t)columns * rows);
+  scratch.resize(density.size());
+  if (bytes > 0) {
+    std::memcpy(density.data(), cursor, bytes);
+  }
+  cursor += bytes;
+  version++;
+  return true;
+}
@@ -0,0 +1,129 @@
+#include "interaction.h"
+#include "arena.h"
+#include "world.h"
+#include <algorithm>
+
+const int InteractionStage::MAX_PROPOSALS;
+
+void InteractionStage::Begin(uint32_t count, Arena &arena) {
+  creatureCount = count;
+  proposals = arena.AllocateArray<Interaction>(count * MAX_PROPOSALS);
+  counts = arena.AllocateArray<uint8_t>(count);
+  std::fill(counts, counts + count, 0);
+  recovering = arena.AllocateArray<bool>(count);
+  std::fill(recovering, recovering + count, false);
+}
+
+// Closest pairs first. A pair proposed from both ends is settled by the
+// proposer with the lower id.
+bool InteractionStage::Before(const Candidate &x, const Candidate &y) {
+  if (x.distance != y.distance) {
+    return x.distance < y.distance;
+  }
+  if (x.lowId != y.lowId) {
+    return x.lowId < y.lowId;
+  }
+  if (x.highId != y.highId) {
+    return x.highId < y.highId;
+  }
+  return x.proposerId < y.proposerId;
+}
+
+void InteractionStage::Match(World &world) {
+  pairs.clear();
+  claims.clear();
+  busy = world.tickArena.AllocateArray<bool>(world.creatures.size());
+  std::fill(busy, busy + world.creatures.size(), false);
+  uint32_t total = 0;
+  for (uint32_t i = 0; i < creatureCount; i++) {
+    total += counts[i];
+  }
+  if (total == 0) {
+    return;
+  }
+
+  Candidate *candidates = world.tickArena.AllocateArray<Candidate>(total);
+  uint32_t next = 0;
+  for (uint32_t i = 0; i < creatureCount; i++) {
+    for (int k = 0; k < counts[i]; k++) {
+      const Interaction &interaction = GetSlots(i)[k];
+      uint32_t a = world.creatures[i].GetId();
+      uint32_t b = world.creatures[interaction.partner].GetId();
+      candidates[next++] = {interaction.distance, std::min(a, b),
+                            std::max(a, b), a, i, interaction.partner,
+                            interaction.kind};
+    }
+  }
+  std::sort(candidates, candidates + total, Before);
+
+  // Greedy matching: a pair is taken only while both ends are free
+  for (uint32_t c = 0; c < total; c++) {
+    const Candidate &candidate = candidates[c];
+    if (busy[candidate.proposer] || busy[candidate.partner]) {
+      continue;
+    }
+    busy[candidate.proposer] = true;
+    busy[candidate.partner] = true;
+    const Creature &partner = world.creatures[candidate.partner];
+    if (partner.IsGhost()) {
+      claims.push_back(InteractionClaim{candidate.proposerId,
+                                        partner.GetId(), candidate.kind,
+                                        candidate.distance});
+    } else {
+      pairs.push_back(candidate);
+    }
+  }
+}
+
+void InteractionStage::Accept(World &world,
+                              const std::vector<InteractionClaim> &incoming) {
+  std::vector<Candidate> offered;
+  for (const InteractionClaim &claim : incoming) {
+    auto proposer = world.indexById.find(claim.proposerId);
+    auto partner = world.indexById.find(claim.partnerId);
+    if (proposer != world.indexById.end() &&
+        partner != world.indexById.end()) {
+      offered.push_back(Candidate{
+          claim.distance, std::min(claim.proposerId, claim.partnerId),
+          std::max(claim.proposerId, claim.partnerId), claim.proposerId,
+          proposer->second, partner->second, claim.kind});
+    }
+  }
+  std::sort(offered.begin(), offered.end(), Before);
+
+  for (const Candidate &candidate : offered) {
+    if (busy[candidate.partner]) {
+      // Still free if its own claim is on the same pair and loses the tie
+      uint32_t partnerId = world.creatures[candidate.partner].GetId();
+      auto own = std::find_if(
+          claims.begin(), claims.end(), [&](const InteractionClaim &claim) {
+            return claim.proposerId == partnerId &&
+                   claim.partnerId == candidate.proposerId;
+          });
+      if (own == claims.end() || candidate.proposerId > partnerId) {
+        continue;
+      }
+    }
+    busy[candidate.partner] = true;
+    pairs.push_back(candidate);
+  }
+}
+
+void InteractionStage::Apply(World &world) {
+  for (uint32_t i = 0; i < creatureCount; i++) {
+    if (recovering[i]) {
+      world.creatures[i].StartRecovery(world);
+    }
+  }
+  outcomes.clear();
+  std::sort(pairs.begin(), pairs.end(), Before);
+  for (const Candidate &pair : pairs) {
+    Creature &proposer = world.creatures[pair.proposer];
+    bool won = proposer.Interact(pair.kind, world.creatures[pair.partner],
+                                 world);
+    if (proposer.IsGhost()) {
+      outcomes.push_back(InteractionOutcome{pair.proposerId, pair.kind, won});
+    }
+  }
+  matched = (uint32_t)pairs.size();
+}
@@ -0,0 +1,323 @@
+#include "lineage.h"
+#include "wire.h"
+#include <algorithm>
+#include <unordered_set>
+
+const uint32_t Lineage::NONE;
+
+uint32_t Lineage::Allocate(uint32_t id) {
+  uint32_t slot;
+  if (!freeSlots.empty()) {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  } else {
+    slot = (uint32_t)nodes.size();
+    nodes.push_back(Node());
+  }
+
+  Node &node = nodes[slot];
+  node.id = id;
+  for (int edge = 0; edge < 2; edge++) {
+    node.parents[edge] = NONE;
+    node.nextSibling[edge] = NONE;
+    node.prevSibling[edge] = NONE;
+  }
+  node.firstChild = NONE;
+  node.refs = 1; // held by the living creature itself
+  node.generation = 0;
+  node.alive = true;
+  node.founder = false;
+
+  slotById[id] = slot;
+  return slot;
+}
+
+uint32_t Lineage::FindSlot(uint32_t id) const {
+  auto it = slotById.find(id);
+  return it == slotById.end() ? NONE : it->second;
+}
+
+void Lineage::LinkChild(uint32_t parent, uint32_t child, int edge) {
+  Node &node = nodes[child];
+  uint32_t link = child * 2 + edge;
+
+  node.parents[edge] = parent;
+  node.prevSibling[edge] = NONE;
+  node.nextSibling[edge] = nodes[parent].firstChild;
+  if (nodes[parent].firstChild != NONE) {
+    uint32_t head = nodes[parent].firstChild;
+    nodes[head / 2].prevSibling[head % 2] = link;
+  }
+  nodes[parent].firstChild = link;
+  nodes[parent].refs++;
+}
+
+void Lineage::UnlinkChild(uint32_t child, int edge) {
+  Node &node = nodes[child];
+  uint32_t parent = node.parents[edge];
+  uint32_t prev = node.prevSibling[edge];
+  uint32_t next = node.nextSibling[edge];
+
+  if (prev != NONE) {
+    nodes[prev / 2].nextSibling[prev % 2] = next;
+  } else {
+    nodes[parent].firstChild = next;
+  }
+  if (next != NONE) {
+    nodes[next / 2].prevSibling[next % 2] = prev;
+  }
+  node.parents[edge] = NONE;
+}
+
+void Lineage::AddFounder(uint32_t id) {
+  if (FindSlot(id) != NONE) {
+    return;
+  }
+  nodes[Allocate(id)].founder = true;
+  founderCount++;
+}
+
+void Lineage::Reserve(size_t count) {
+  nodes.reserve(nodes.size() + count);
+  slotById.reserve(slotById.size() + count);
+}
+
+void Lineage::AddBirth(uint32_t id, uint32_t parentA, uint32_t parentB) {
+  if (FindSlot(id) != NONE) {
+    return;
+  }
+  uint32_t slotA = FindSlot(parentA);
+  uint32_t slotB = parentB == parentA ? NONE : FindSlot(parentB);
+
+  // Untracked parents (e.g. after a Clear) make this a new founder
+  if (slotA == NONE && slotB == NONE) {
+    AddFounder(id);
+    return;
+  }
+
+  LinkParents(Allocate(id), parentA, parentB);
+}
+
+void Lineage::LinkParents(uint32_t slot, uint32_t parentA, uint32_t parentB) {
+  uint32_t slotA = FindSlot(parentA);
+  uint32_t slotB = parentB == parentA ? NONE : FindSlot(parentB);
+  uint32_t generation = 0;
+  if (slotA != NONE) {
+    LinkChild(slotA, slot, 0);
+    generation = std::max(generation, nodes[slotA].generation + 1);
+  }
+  if (slotB != NONE) {
+    LinkChild(slotB, slot, 1);
+    generation = std::max(generation, nodes[slotB].generation + 1);
+  }
+  nodes[slot].generation = generation;
+}
+
+Lineage::Placement Lineage::GetPlacement(uint32_t id) const {
+  Placement placement = {{NONE, NONE}, -1, false};
+  uint32_t slot = FindSlot(id);
+  if (slot == NONE) {
+    return placement;
+  }
+  for (int edge = 0; edge < 2; edge++) {
+    uint32_t parent = nodes[slot].parents[edge];
+    placement.parents[edge] = parent == NONE ? NONE : nodes[parent].id;
+  }
+  placement.generation = (int)nodes[slot].generation;
+  placement.founder = nodes[slot].founder;
+  return placement;
+}
+
+void Lineage::AddMigrant(uint32_t id, const Placement &placement) {
+  if (FindSlot(id) != NONE) {
+    return;
+  }
+  if (placement.founder) {
+    AddFounder(id);
+    return;
+  }
+  uint32_t slot = Allocate(id);
+  LinkParents(slot, placement.parents[0], placement.parents[1]);
+  if (placement.generation >= 0) {
+    nodes[slot].generation = (uint32_t)placement.generation;
+  }
+}
+
+void Lineage::Depart(uint32_t id) {
+  // Its place in this tree goes as on a death: ancestors stay only while
+  // something alive here descends from them
+  uint32_t slot = FindSlot(id);
+  if (slot != NONE && nodes[slot].alive) {
+    nodes[slot].alive = false;
+    Release(slot);
+  }
+}
+
+void Lineage::RecordDeath(uint32_t id) {
+  uint32_t slot = FindSlot(id);
+  if (slot == NONE || !nodes[slot].alive) {
+    return;
+  }
+  nodes[slot].alive = false;
+  Release(slot);
+}
+
+void Lineage::Release(uint32_t slot) {
+  // Iterative so that pruning a very deep chain cannot blow the stack
+  std::vector<uint32_t> &pending = releaseStack;
+  pending.assign(1, slot);
+  while (!pending.empty()) {
+    uint32_t current = pending.back();
+    pending.pop_back();
+
+    Node &node = nodes[current];
+    if (--node.refs > 0) {
+      continue;
+    }
+
+    // Nothing alive descends from this node any more
+    for (int edge = 0; edge < 2; edge++) {
+      uint32_t parent = node.parents[edge];
+      if (parent != NONE) {
+        UnlinkChild(current, edge);
+        pending.push_back(parent);
+      }
+    }
+    if (node.founder) {
+      founderCount--;
+    }
+
+    slotById.erase(node.id);
+    freeSlots.push_back(current);
+  }
+}
+
+void Lineage::Clear() {
+  nodes.clear();
+  freeSlots.clear();
+  slotById.clear();
+  founderCount = 0;
+}
+
+void Lineage::Write(std::vector<uint8_t> &out) const {
+  Wire::Put(out, (uint32_t)nodes.size());
+  for (const Node &node : nodes) {
+    Wire::Put(out, node);
+  }
+  Wire::Put(out, (uint32_t)freeSlots.size());
+  for (uint32_t slot : freeSlots) {
+    Wire::Put(out, slot);
+  }
+  Wire::Put(out, founderCount);
+}
+
+bool Lineage::Read(const uint8_t *&cursor, const uint8_t *end) {
+  Clear();
+  uint32_t count;
+  if (!Wire::Get(cursor, end, count)) {
+    return false;
+  }
+  nodes.resize(count);
+  for (Node &node : nodes) {
+    if (!Wire::Get(cursor, end, node)) {
+      return false;
+    }
+  }
+  if (!Wire::Get(cursor, end, count)) {
+    return false;
+  }
+  freeSlots.resize(count);
+  std::vector<bool> free(nodes.size(), false);
+  for (uint32_t &slot : freeSlots) {
+    if (!Wire::Get(cursor, end, slot) || slot >= nodes.size()) {
+      return false;
+    }
+    free[slot] = true;
+  }
+  for (uint32_t slot = 0; slot < nodes.size(); slot++) {
+    if (!free[slot]) {
+      slotById[nodes[slot].id] = slot;
+    }
+  }
+  return Wire::Get(cursor, end, founderCount);
+}
+
+bool Lineage::Contains(uint32_t id) const { return FindSlot(id) != NONE; }
+
+int Lineage::GetGeneration(uint32_t id) const {
+  uint32_t slot = FindSlot(id);
+  return slot == NONE ? -1 : (int)nodes[slot].generation;
+}
+
+std::vector<uint32_t> Lineage::GetAncestors(uint32_t id, int maxDepth) const {
+  std::vector<uint32_t> result;
+  uint32_t slot = FindSlot(id);
+  if (slot == NONE) {
+    return result;
+  }
+
+  // Breadth-first so that results come out nearest generation first; the
+  // visited set collapses ancestors reached through both parents.
+  std::unordered_set<uint32_t> visited;
+  std::vector<uint32_t> frontier(1, slot);
+  for (int depth = 0; !frontier.empty() && depth != maxDepth; depth++) {
+    std::vector<uint32_t> next;
+    for (uint32_t current : frontier) {
+      for (int edge = 0; edge < 2; edge++) {
+        uint32_t parent = nodes[current].parents[edge];
+        if (parent != NONE && visited.insert(parent).second) {
+          result.push_back(nodes[parent].id);
+          next.push_back(parent);
+        }
+      }
+    }
+    frontier.swap(next);
+  }
+  return result;
+}
+
+std::vector<uint32_t> Lineage::GetDescendants(uint32_t id,
+                                              bool livingOnly) const {
+  std::vector<uint32_t> result;
+  uint32_t slot = FindSlot(id);
+  if (slot == NONE) {
+    return result;
+  }
+
+  std::unordered_set<uint32_t> visited;
+  std::vector<uint32_t> pending(1, slot);
+  while (!pending.empty()) {
+    uint32_t current = pending.back();
+    pending.pop_back();
+
+    for (uint32_t link = nodes[current].firstChild; link != NONE;
+         link = nodes[link / 2].nextSibling[link % 2]) {
+      uint32_t child = link / 2;
+      if (!visited.insert(child).second) {
+        continue;
+      }
+      if (!livingOnly || nodes[child].alive) {
+        result.push_back(nodes[child].id);
+      }
+      pending.push_back(child);
+    }
+  }
+  return result;
+}
+
+std::vector<uint32_t> Lineage::GetSurvivingFounders() const {
+  std::vector<uint32_t> result;
+  result.reserve(founderCount);
+
+  std::vector<bool> isFree(nodes.size(), false);
+  for (uint32_t slot : freeSlots) {
+    isFree[slot] = true;
+  }
+  for (uint32_t slot = 0; slot < nodes.size(); slot++) {
+    const Node &node = nodes[slot];
+    if (!isFree[slot] && node.founder) {
+      result.push_back(node.id);
+    }
+  }
+  return result;
+}
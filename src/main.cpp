@@ -1,11 +1,209 @@
+#include <chrono>
 #include <cmath>
+#include "alloc_counter.h"
+#include "arena.h"
 #include "constants.h"
 #include "creature.h"
+#include "differential.h"
+#include "domain.h"
 #include "food.h"
+#include "perf_counters.h"
+#include "phase_profile.h"
 #include "raylib.h"
+#include "recorder.h"
+#include "rewind.h"
+#include "scenario.h"
+#include "seed_stats.h"
+#include "shared_export.h"
+#include "snapshot_stream.h"
+#include "soak.h"
+#include "trajectory.h"
+#include "world.h"
+#include "world_gen.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <sys/wait.h>
+#include <unistd.h>
 
 float simulationSpeed = 1.0f; // Global simulation speed multiplier
 
+typedef std::reference_wrapper<Creature> CreatureRef;
+typedef std::reference_wrapper<const Creature> ConstCreatureRef;
+
+// Command line options
+struct Options {
+  bool headless = false;  // Hidden window, ticks as fast as possible
+  bool brains = false;    // Neural network brains steer the creatures
+  bool multiRate = false; // Update off-screen creatures less often
+  bool foodField = false; // Food as a density field instead of items
+  bool contagion = true;  // Sick creatures infect those nearby
+  bool fighting = true;   // Creatures fight over food and mates
+  Layout creatureLayout = Layout::UNIFORM; // Where the founders start
+  Layout foodLayout = Layout::UNIFORM;     // And the initial food
+  float duration = 0.0f;  // Simulation seconds to run, 0 for unlimited
+  std::string recordDirectory; // Empty unless recording
+  FrameFormat recordFormat = FrameFormat::PNG;
+  float recordFps = 30.0f; // Frames per simulation second
+  int recordWorkers = 2;
+  std::string streamPath; // Unix socket for external viewers, if set
+  std::string sharedName; // POSIX shared-memory export, if set
+  int sharedCapacity = 4096; // Creature and food rows in the export
+  std::string trajectoryPath; // Per-creature path and state file, if set
+  int rewindBudget = 64;    // Megabytes of rewind history, 0 to disable
+  int rewindInterval = 120; // Ticks between rewind keyframes
+  int tileColumns = 1; // Above one tile, one headless process per tile
+  int tileRows = 1;
+  bool perfCounters = false; // Log a per-phase profile at the end
+  int differentialTicks = 0; // Check Step against the reference engine
+  int seedStatsTicks = 0; // Measure population and traits over six seeds
+  std::string statsSavePath;    // Where to save them, if set
+  std::string statsComparePath; // Another build's, to hold them to
+  bool soak = false; // Headless run of duration watched for leaks
+  unsigned seed = 0; // Random seed, 0 for one from the clock
+};
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--headless") == 0) {
+      options.headless = true;
+    } else if (strcmp(argv[i], "--brains") == 0) {
+      options.brains = true;
+    } else if (strcmp(argv[i], "--multi-rate") == 0) {
+      options.multiRate = true;
+    } else if (strcmp(argv[i], "--food-field") == 0) {
+      options.foodField = true;
+    } else if (strcmp(argv[i], "--perf-counters") == 0) {
+      options.perfCounters = true;
+    } else if (strcmp(argv[i], "--scenario") == 0 && hasValue) {
+      // Sets Constants now, before anything reads them; later options
+      // still win over the file's toggles
+      ScenarioFeatures features;
+      features.contagion = options.contagion;
+      features.fighting = options.fighting;
+      features.foodField = options.foodField;
+      features.creatureLayout = options.creatureLayout;
+      features.foodLayout = options.foodLayout;
+      Scenario::Load(argv[++i], features);
+      options.contagion = features.contagion;
+      options.fighting = features.fighting;
+      options.foodField = features.foodField;
+      options.creatureLayout = features.creatureLayout;
+      options.foodLayout = features.foodLayout;
+    } else if (strcmp(argv[i], "--soak") == 0 && hasValue) {
+      options.soak = true;
+      options.duration = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--differential") == 0 && hasValue) {
+      options.differentialTicks = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed-stats") == 0 && hasValue) {
+      options.seedStatsTicks = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--stats-save") == 0 && hasValue) {
+      options.statsSavePath = argv[++i];
+    } else if (strcmp(argv[i], "--stats-compare") == 0 && hasValue) {
+      options.statsComparePath = argv[++i];
+    } else if (strcmp(argv[i], "--duration") == 0 && hasValue) {
+      options.duration = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--record") == 0 && hasValue) {
+      options.recordDirectory = argv[++i];
+    } else if (strcmp(argv[i], "--record-format") == 0 && hasValue) {
+      options.recordFormat = strcmp(argv[++i], "raw") == 0 ? FrameFormat::RAW
+                                                           : FrameFormat::PNG;
+    } else if (strcmp(argv[i], "--record-fps") == 0 && hasValue) {
+      options.recordFps = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--record-workers") == 0 && hasValue) {
+      options.recordWorkers = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--stream") == 0 && hasValue) {
+      options.streamPath = argv[++i];
+    } else if (strcmp(argv[i], "--shm") == 0 && hasValue) {
+      options.sharedName = argv[++i];
+    } else if (strcmp(argv[i], "--shm-capacity") == 0 && hasValue) {
+      options.sharedCapacity = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--trajectory") == 0 && hasValue) {
+      options.trajectoryPath = argv[++i];
+    } else if (strcmp(argv[i], "--rewind-budget") == 0 && hasValue) {
+      options.rewindBudget = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--rewind-interval") == 0 && hasValue) {
+      options.rewindInterval = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+      options.seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--tiles") == 0 && hasValue) {
+      if (sscanf(argv[++i], "%dx%d", &options.tileColumns,
+                 &options.tileRows) != 2 ||
+          options.tileColumns < 1 || options.tileRows < 1) {
+        TraceLog(LOG_WARNING, "TILES: Expected COLUMNSxROWS, got %s", argv[i]);
+        options.tileColumns = 1;
+        options.tileRows = 1;
+      }
+    }
+  }
+  if (options.differentialTicks > 0 || options.seedStatsTicks > 0 ||
+      options.soak) {
+    options.headless = true;
+  }
+  if (options.tileColumns * options.tileRows > 1) {
+    options.headless = true; // Tile processes have nothing to draw
+    if (options.foodField) {
+      TraceLog(LOG_WARNING, "FIELD: Not supported with --tiles, using items");
+      options.foodField = false;
+    }
+  }
+  return options;
+}
+
+// Creatures ordered oldest first
+ArenaVector<ConstCreatureRef> SortByAge(const std::vector<Creature> &creatures,
+                                        Arena &arena) {
+  ArenaVector<ConstCreatureRef> sorted(creatures.begin(), creatures.end(),
+                                       ArenaAllocator<ConstCreatureRef>(&arena));
+  std::sort(sorted.begin(), sorted.end(),
+            [](const Creature &a, const Creature &b) {
+              return a.GetAge() > b.GetAge();
+            });
+  return sorted;
+}
+
+// Draws everything that lives in world space
+void DrawWorld(const World &world, const ArenaVector<ConstCreatureRef> &byAge,
+               Arena &arena) {
+  // Draw world border using current window size
+  // Draw world border with gradient
+  Color borderColor = ColorAlpha(LIGHTGRAY, 0.3f);
+  DrawRectangleLinesEx(
+      Rectangle{0, 0, (float)GetScreenWidth(), (float)GetScreenHeight()}, 2,
+      borderColor);
+
+  // Draw grid dots
+  int gridSpacing = 50; // Adjust for dot density
+  Color dotColor = ColorAlpha(GRAY, 0.2f);
+  for (int x = 0; x < GetScreenWidth(); x += gridSpacing) {
+    for (int y = 0; y < GetScreenHeight(); y += gridSpacing) {
+      DrawCircle(x, y, 2, dotColor);
+    }
+  }
+
+  // Draw food
+  world.foodField.Draw();
+  for (const auto &food : world.foods) {
+    food.Draw();
+  }
+
+  // Rank of each creature by age
+  const std::vector<Creature> &creatures = world.creatures;
+  ArenaVector<int> ranks(creatures.size(), 0, ArenaAllocator<int>(&arena));
+  for (size_t i = 0; i < byAge.size(); i++) {
+    ranks[&byAge[i].get() - creatures.data()] = (int)i + 1;
+  }
+
+  // Draw creatures with rank
+  for (size_t i = 0; i < creatures.size(); i++) {
+    creatures[i].Draw(ranks[i], creatures);
+  }
+}
+
 void DrawGameOverScreen(float totalAge, int totalCreatures) {
   BeginDrawing();
   ClearBackground(BLACK);
@@ -30,12 +228,319 @@ void DrawGameOverScreen(float totalAge, int totalCreatures) {
   EndDrawing();
 }
 
-int main() {
+void DrawTraitPanel(const TraitStats &stats, int x, int y, int width) {
+  const int ROW_HEIGHT = 34;
+  const int HISTOGRAM_HEIGHT = 14;
+  const int height = 30 + ROW_HEIGHT * (int)Trait::COUNT;
+
+  DrawRectangle(x, y, width, height, Color{20, 20, 40, 230});
+  DrawRectangleLinesEx(
+      Rectangle{(float)x, (float)y, (float)width, (float)height}, 1,
+      ColorAlpha(LIGHTGRAY, 0.3f));
+  DrawText("TRAITS", x + 10, y + 5, 20, YELLOW);
+
+  const int barWidth = (width - 20) / TraitHistogram::BINS;
+  for (int t = 0; t < (int)Trait::COUNT; t++) {
+    const TraitHistogram &histogram = stats.Get((Trait)t);
+    int rowY = y + 30 + t * ROW_HEIGHT;
+
+    DrawText(TextFormat("%s  %.2f +/- %.2f", TraitStats::GetName((Trait)t),
+                        histogram.GetMean(), histogram.GetStdDev()),
+             x + 10, rowY, 12, WHITE);
+
+    // Bars are scaled to the fullest bin of this trait
+    int peak = histogram.GetBin(histogram.GetPeakBin());
+    for (int b = 0; b < TraitHistogram::BINS && peak > 0; b++) {
+      int barHeight = histogram.GetBin(b) * HISTOGRAM_HEIGHT / peak;
+      DrawRectangle(x + 10 + b * barWidth,
+                    rowY + 14 + HISTOGRAM_HEIGHT - barHeight, barWidth - 1,
+                    barHeight, ColorAlpha(SKYBLUE, 0.8f));
+    }
+  }
+}
+
+// Starts counting for the --perf-counters report, which falls back to
+// timings alone where there are no hardware counters
+void StartProfile(const Options &options, PerfCounters &counters,
+                  World &world) {
+  if (!options.perfCounters) {
+    return;
+  }
+  if (counters.Open()) {
+    world.perfCounters = &counters;
+  } else {
+    TraceLog(LOG_WARNING, "PERF: No hardware counters (%s), timing only",
+             counters.GetError());
+  }
+}
+
+// Spawns the founders, and the initial food unless it grows in a field, laid
+// out over the screen as the options say. A tile keeps only its own part.
+void Populate(World &world, const Options &options, int width, int height,
+              bool withFood, const DomainNode *node = nullptr) {
+  WorldGenConfig config;
+  if (node) {
+    config.keep = [node](Vector2 position) { return node->Owns(position); };
+  }
+  config.bounds = Rectangle{0, 0, (float)width, (float)height};
+  // From the session's generator, so a seeded run starts the same way
+  config.seed = (uint64_t)GetRandomValue(0, 0xFFFF) << 16 |
+                (uint64_t)GetRandomValue(0, 0xFFFF);
+  config.creatureCount = Constants::INITIAL_CREATURE_COUNT;
+  config.foodCount = withFood && !world.foodField.IsEnabled()
+                         ? Constants::INITIAL_FOOD_COUNT
+                         : 0;
+  config.creatureLayout = options.creatureLayout;
+  config.foodLayout = options.foodLayout;
+  WorldGen::Generate(world, config);
+  world.seed = config.seed;
+}
+
+// Runs the batched Step and the reference engine side by side, reporting
+// the first tick on which they part
+int RunDifferential(const Options &options) {
+  DifferentialConfig config;
+  config.ticks = (uint64_t)options.differentialTicks;
+  config.brains = options.brains;
+  config.foodField = options.foodField;
+  config.contagion = options.contagion;
+  config.fighting = options.fighting;
+  config.multiRate = options.multiRate;
+  if (options.seed) {
+    config.seed = options.seed;
+  }
+  Differential differential(config);
+  if (!differential.Run()) {
+    TraceLog(LOG_WARNING, "DIFF: %s", differential.GetReport().c_str());
+    return 1;
+  }
+  TraceLog(LOG_INFO, "DIFF: Engines agreed on %llu ticks",
+           (unsigned long long)differential.GetTicksCompared());
+  return 0;
+}
+
+// Runs six seeds for --seed-stats, saving their means or holding them to
+// another build's
+int RunSeedStats(const Options &options) {
+  SeedStatsConfig config;
+  config.ticks = (uint64_t)options.seedStatsTicks;
+  config.brains = options.brains;
+  config.foodField = options.foodField;
+  config.contagion = options.contagion;
+  config.fighting = options.fighting;
+  if (options.seed) {
+    config.firstSeed = options.seed;
+  }
+  SeedStats stats(config);
+  stats.Run();
+  if (!options.statsSavePath.empty() && !stats.Save(options.statsSavePath)) {
+    return 1;
+  }
+  if (options.statsComparePath.empty()) {
+    return 0;
+  }
+  bool agree = stats.Compare(options.statsComparePath);
+  TraceLog(agree ? LOG_INFO : LOG_WARNING, "STATS: %s against %s:\n%s",
+           agree ? "Agreed" : "Differed", options.statsComparePath.c_str(),
+           stats.GetReport().c_str());
+  return agree ? 0 : 1;
+}
+
+// Runs one tile of a decomposed world until the duration is up or a
+// neighbour goes away. Every tile seeds the shared generator with the run's
+// seed and draws the whole world's founders and food, keeping its own, so a
+// tiled run starts as a single-process run with the same --seed does. Ids
+// born on a tile come from a range of its own above the founders'. Streams,
+// exports and trajectories get the tile number appended.
+int RunTile(const Options &options, const TileLayout &layout, int tile,
+            const std::vector<int> &sockets, unsigned seed) {
+  SocketTransport transport(sockets);
+  SetRandomSeed(seed);
+
+  World world;
+  world.brainsEnabled = options.brains;
+  world.contagionEnabled = options.contagion;
+  world.fightingEnabled = options.fighting;
+  DomainNode node(layout, tile, transport, world);
+  const std::string suffix = TextFormat(".%d", tile);
+
+  SnapshotServer snapshots;
+  if (!options.streamPath.empty() &&
+      !snapshots.Open(options.streamPath + suffix, layout.worldWidth,
+                      layout.worldHeight)) {
+    TraceLog(LOG_WARNING, "STREAM: Could not open %s%s",
+             options.streamPath.c_str(), suffix.c_str());
+  }
+  SharedExport sharedExport;
+  const uint32_t sharedCapacity = (uint32_t)std::max(options.sharedCapacity, 0);
+  if (!options.sharedName.empty() &&
+      !sharedExport.Open(options.sharedName + suffix, sharedCapacity,
+                         sharedCapacity, layout.worldWidth,
+                         layout.worldHeight)) {
+    TraceLog(LOG_WARNING, "SHM: Could not open %s%s",
+             options.sharedName.c_str(), suffix.c_str());
+  }
+  TrajectoryWriter trajectory;
+  if (!options.trajectoryPath.empty() &&
+      !trajectory.Open(options.trajectoryPath + suffix)) {
+    TraceLog(LOG_WARNING, "TRAJECTORY: Could not open %s%s",
+             options.trajectoryPath.c_str(), suffix.c_str());
+  }
+  PerfCounters perfCounters;
+  PhaseProfile profile;
+  StartProfile(options, perfCounters, world);
+
+  Populate(world, options, (int)layout.worldWidth, (int)layout.worldHeight,
+           true, &node);
+  const uint32_t founders = Creature::GetNextId();
+  const uint32_t span = (0xFFFFFFFFu - founders) / layout.GetCount();
+  Creature::ReserveIds(founders + span * tile, founders + span * (tile + 1));
+
+  // Nothing else on a tile draws from the shared generator, so every tile
+  // spawns the food a single-process run would and keeps its own
+  auto randomPosition = [&]() {
+    return Vector2{(float)GetRandomValue(0, (int)layout.worldWidth),
+                   (float)GetRandomValue(0, (int)layout.worldHeight)};
+  };
+
+  const float fixedDeltaTime = Constants::PHYSICS_TIMESTEP;
+  float foodSpawnTimer = 0;
+  float reportTimer = 0;
+  while (options.duration <= 0 || world.simulationTime < options.duration) {
+    foodSpawnTimer += fixedDeltaTime;
+    if (foodSpawnTimer >= Constants::FOOD_SPAWN_INTERVAL) {
+      for (int i = 0; i < Constants::FOOD_SPAWN_COUNT; i++) {
+        Vector2 foodPos = randomPosition();
+        if (node.Owns(foodPos)) {
+          world.foods.emplace_back(foodPos);
+        }
+      }
+      foodSpawnTimer = 0;
+    }
+
+    if (!node.Step(fixedDeltaTime)) {
+      TraceLog(LOG_WARNING, "TILES: Tile %d lost a neighbour", tile);
+      return 1;
+    }
+    snapshots.Publish(world, world.tickCount);
+    sharedExport.Publish(world);
+    trajectory.Record(world);
+    if (options.perfCounters) {
+      profile.Add(world);
+    }
+
+    reportTimer += fixedDeltaTime;
+    if (reportTimer >= 10.0f) {
+      TraceLog(LOG_INFO, "TILES: Tile %d at %.0fs: %d creatures, %d food",
+               tile, world.simulationTime, (int)world.creatures.size(),
+               (int)world.foods.size());
+      reportTimer = 0;
+    }
+  }
+  if (options.perfCounters) {
+    profile.Log(TextFormat("Tile %d", tile), perfCounters);
+  }
+  return 0;
+}
+
+// Forks one process per tile, linked to its neighbours by socket pairs, and
+// waits for them all
+int RunTiles(const Options &options, int screenWidth, int screenHeight) {
+  TileLayout layout;
+  layout.columns = options.tileColumns;
+  layout.rows = options.tileRows;
+  layout.worldWidth = (float)screenWidth;
+  layout.worldHeight = (float)screenHeight;
+
+  // Halos may only reach the adjacent tiles
+  Rectangle bounds = layout.GetBounds(0);
+  if (bounds.width < Constants::PERCEPTION_RANGE ||
+      bounds.height < Constants::PERCEPTION_RANGE) {
+    TraceLog(LOG_WARNING, "TILES: Tiles must be at least %.0f across",
+             Constants::PERCEPTION_RANGE);
+    return 1;
+  }
+
+  // Logged so that a run can be repeated with --seed
+  unsigned seed = options.seed ? options.seed : (unsigned)time(nullptr);
+  TraceLog(LOG_INFO, "TILES: Seed %u", seed);
+
+  std::vector<std::vector<int>> links = SocketTransport::Connect(layout);
+  std::vector<pid_t> children;
+  for (int tile = 0; tile < layout.GetCount(); tile++) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      TraceLog(LOG_WARNING, "TILES: Could not start tile %d", tile);
+      break; // The tiles already running stop when their neighbours fail
+    }
+    if (pid == 0) {
+      std::vector<int> sockets;
+      for (int neighbour : layout.GetNeighbours(tile)) {
+        sockets.push_back(links[tile][neighbour]);
+        links[tile][neighbour] = -1;
+      }
+      for (const auto &row : links) {
+        for (int fd : row) {
+          if (fd >= 0) {
+            close(fd);
+          }
+        }
+      }
+      // Skip exit handlers, which belong to the parent
+      _exit(RunTile(options, layout, tile, sockets, seed));
+    }
+    children.push_back(pid);
+  }
+  for (const auto &row : links) {
+    for (int fd : row) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  int result = (int)children.size() == layout.GetCount() ? 0 : 1;
+  for (pid_t pid : children) {
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      result = 1;
+    }
+  }
+  return result;
+}
+
+int main(int argc, char **argv) {
+  const Options options = ParseOptions(argc, argv);
   const int screenWidth = Constants::SCREEN_WIDTH;
   const int screenHeight = Constants::SCREEN_HEIGHT;
-  SetConfigFlags(FLAG_WINDOW_RESIZABLE);
-  SetConfigFlags(FLAG_WINDOW_TOPMOST);
+  // Tile processes are forked before there is a window or GL context for
+  // them to inherit
+  if (options.tileColumns * options.tileRows > 1) {
+    return RunTiles(options, screenWidth, screenHeight);
+  }
+  if (options.headless) {
+    // Still needs a GL context for recording, e.g. under xvfb-run
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+  } else {
+    SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+    SetConfigFlags(FLAG_WINDOW_TOPMOST);
+  }
   InitWindow(screenWidth, screenHeight, "Creature Sim");
+  if (options.seed) {
+    SetRandomSeed(options.seed); // InitWindow seeds from the clock
+  }
+
+  if (options.differentialTicks > 0) {
+    int result = RunDifferential(options);
+    CloseWindow();
+    return result;
+  }
+  if (options.seedStatsTicks > 0) {
+    int result = RunSeedStats(options);
+    CloseWindow();
+    return result;
+  }
 
   bool gameOver = false;
   float totalSimulationAge = 0.0f;
@@ -73,18 +578,107 @@ int main() {
   const float fixedDeltaTime = Constants::PHYSICS_TIMESTEP;
   float accumulator = 0.0f;
 
-  std::vector<Creature> creatures;
-  std::vector<Food> foods;
+  World world;
+  world.brainsEnabled = options.brains;
+  world.contagionEnabled = options.contagion;
+  world.fightingEnabled = options.fighting;
+  // Without a visible camera there is nothing to focus on
+  world.multiRate = options.multiRate && !options.headless;
+  std::vector<Creature> &creatures = world.creatures;
+  std::vector<Food> &foods = world.foods;
+
+  // Per-frame temporaries (sort buffers) live here and are released together
+  // at the end of every frame
+  Arena frameArena;
+  uint64_t lastFrameAllocations = 0;
+
+  // Offscreen recording of the whole world at a fixed simulation cadence
+  std::unique_ptr<Recorder> recorder;
+  const Camera2D recordCamera = {{0, 0}, {0, 0}, 0.0f, 1.0f};
+  if (!options.recordDirectory.empty()) {
+    RecorderConfig config;
+    config.directory = options.recordDirectory;
+    config.format = options.recordFormat;
+    config.interval = 1.0f / options.recordFps;
+    config.width = screenWidth;
+    config.height = screenHeight;
+    config.workers = options.recordWorkers;
+    recorder.reset(new Recorder(config));
+  }
 
-  float foodSpawnTimer = 0;
+  // World frames for external viewers
+  SnapshotServer snapshots;
+  if (!options.streamPath.empty() &&
+      !snapshots.Open(options.streamPath, (float)screenWidth,
+                      (float)screenHeight)) {
+    TraceLog(LOG_WARNING, "STREAM: Could not open %s",
+             options.streamPath.c_str());
+  }
+
+  // Columnar world state for analysis tools that map it directly
+  SharedExport sharedExport;
+  const uint32_t sharedCapacity = (uint32_t)std::max(options.sharedCapacity, 0);
+  if (!options.sharedName.empty() &&
+      !sharedExport.Open(options.sharedName, sharedCapacity, sharedCapacity,
+                         (float)screenWidth, (float)screenHeight)) {
+    TraceLog(LOG_WARNING, "SHM: Could not open %s",
+             options.sharedName.c_str());
+  }
+
+  // Every creature's path and states, for reading back one life at a time
+  TrajectoryWriter trajectory;
+  if (!options.trajectoryPath.empty() &&
+      !trajectory.Open(options.trajectoryPath)) {
+    TraceLog(LOG_WARNING, "TRAJECTORY: Could not open %s",
+             options.trajectoryPath.c_str());
+  }
+
+  // Where each phase's time goes, reported when the run ends
+  PerfCounters perfCounters;
+  PhaseProfile profile;
+  StartProfile(options, perfCounters, world);
+
+  // Memory and tick-time trends over a long run
+  SoakMonitor soak;
+
+  // Recent history for scrubbing back; there is no one to scrub headless
+  std::unique_ptr<Rewind> rewind;
+  if (!options.headless && options.rewindBudget > 0) {
+    rewind.reset(new Rewind((size_t)options.rewindBudget << 20,
+                            (uint32_t)std::max(options.rewindInterval, 1)));
+  }
+
+  // One tick of the simulation, shared by live ticks and rewind replays
   const float foodSpawnInterval = Constants::FOOD_SPAWN_INTERVAL;
-  for (int i = 0; i < Constants::INITIAL_CREATURE_COUNT; i++) {
-    Vector2 pos = {(float)GetRandomValue(0, screenWidth),
-                   (float)GetRandomValue(0, screenHeight)};
-    creatures.emplace_back(pos, Constants::INITIAL_CREATURE_SIZE);
+  auto runTick = [&](const TickInput &input) {
+    // Spawn food periodically, unless it grows in the field
+    if (!world.foodField.IsEnabled()) {
+      world.foodSpawnTimer += fixedDeltaTime;
+    }
+    if (world.foodSpawnTimer >= foodSpawnInterval) {
+      // Spawn multiple food items each time
+      for (int i = 0; i < Constants::FOOD_SPAWN_COUNT; i++) {
+        Vector2 foodPos = {(float)GetRandomValue(0, screenWidth),
+                           (float)GetRandomValue(0, screenHeight)};
+        foods.emplace_back(foodPos);
+      }
+      world.foodSpawnTimer = 0;
+    }
+
+    world.focusRegion = input.focusRegion;
+    world.focusId = input.focusId;
+    world.Step(input.deltaTime);
+  };
+
+  if (options.foodField) {
+    world.foodField.Reset((float)screenWidth, (float)screenHeight);
   }
+  Populate(world, options, screenWidth, screenHeight, true);
+
+  while (!WindowShouldClose() && !creatures.empty() &&
+         !(options.duration > 0 && world.simulationTime >= options.duration)) {
+    uint64_t frameAllocationsStart = AllocCounter::GetCount();
 
-  while (!WindowShouldClose() && !creatures.empty()) {
     // Handle keyboard input
     if (IsKeyPressed(KEY_F)) {
       if (IsWindowFullscreen()) {
@@ -171,8 +765,9 @@ int main() {
     // Navigate between creatures using arrow keys and number keys
     if (!creatures.empty()) {
       // Sort creatures by age for consistent navigation
-      std::vector<std::reference_wrapper<Creature>> sorted_creatures(
-          creatures.begin(), creatures.end());
+      ArenaVector<CreatureRef> sorted_creatures(
+          creatures.begin(), creatures.end(),
+          ArenaAllocator<CreatureRef>(&frameArena));
       std::sort(sorted_creatures.begin(), sorted_creatures.end(),
                 [](const Creature &a, const Creature &b) {
                   return a.GetAge() > b.GetAge();
@@ -200,7 +795,7 @@ int main() {
         // Find current creature's index
         auto it = std::find_if(
             sorted_creatures.begin(), sorted_creatures.end(),
-            [&selectedCreature](const std::reference_wrapper<Creature> &ref) {
+            [&selectedCreature](const CreatureRef &ref) {
               return &ref.get() == selectedCreature;
             });
 
@@ -228,7 +823,7 @@ int main() {
         // Find current creature's index
         auto it = std::find_if(
             sorted_creatures.begin(), sorted_creatures.end(),
-            [&selectedCreature](const std::reference_wrapper<Creature> &ref) {
+            [&selectedCreature](const CreatureRef &ref) {
               return &ref.get() == selectedCreature;
             });
 
@@ -325,22 +920,43 @@ int main() {
       }
     }
 
-    accumulator += GetFrameTime();
+    // Scrub through the recent past. The world replays forward from wherever
+    // it lands and rejoins the live edge on its own.
+    if (rewind) {
+      uint64_t target = world.tickCount;
+      bool seek = false;
+      if (IsKeyPressed(KEY_LEFT_BRACKET)) {
+        target -= std::min(target, (uint64_t)Constants::REWIND_SEEK_TICKS);
+        seek = true;
+      }
+      if (IsKeyPressed(KEY_RIGHT_BRACKET)) {
+        target += Constants::REWIND_SEEK_TICKS;
+        seek = true;
+      }
+      if (IsKeyPressed(KEY_BACKSPACE)) {
+        target = rewind->GetLiveTick();
+        seek = true;
+      }
+      if (seek) {
+        uint32_t selectedId =
+            selectedCreature ? selectedCreature->GetId() : Lineage::NONE;
+        rewind->Seek(world, target, runTick);
+        selectedCreature = world.Find(selectedId);
+        if (selectedCreature) {
+          selectedCreature->SetSelected(true);
+        }
+      }
+    }
+
+    // Headless runs are not paced by the display
+    accumulator += options.headless ? fixedDeltaTime : GetFrameTime();
 
     while (accumulator >= fixedDeltaTime) {
-      // Accumulate total simulation time
-      totalSimulationTime += fixedDeltaTime * simulationSpeed;
-
-      // Spawn food periodically
-      foodSpawnTimer += fixedDeltaTime;
-      if (foodSpawnTimer >= foodSpawnInterval) {
-        // Spawn multiple food items each time
-        for (int i = 0; i < Constants::FOOD_SPAWN_COUNT; i++) {
-          Vector2 foodPos = {(float)GetRandomValue(0, screenWidth),
-                             (float)GetRandomValue(0, screenHeight)};
-          foods.emplace_back(foodPos);
-        }
-        foodSpawnTimer = 0;
+      // Replayed ticks were already counted when they ran live
+      const bool replaying = rewind && rewind->IsReplaying(world);
+      if (!replaying) {
+        // Accumulate total simulation time
+        totalSimulationTime += fixedDeltaTime * simulationSpeed;
       }
 
       // Handle simulation speed control with more consistent key handling
@@ -358,26 +974,56 @@ int main() {
         simulationSpeed = 1.0f;
       }
 
-      // Update all creatures
-      for (auto &creature : creatures) {
-        creature.Update(fixedDeltaTime * simulationSpeed, creatures, foods,
-                        creatures);
+      // Update creatures, admit births and remove the dead. Storage may be
+      // rearranged, so the selection is looked up again by id.
+      uint32_t selectedId =
+          selectedCreature ? selectedCreature->GetId() : Lineage::NONE;
+      Vector2 viewMin = GetScreenToWorld2D({0, 0}, camera);
+      Vector2 viewMax = GetScreenToWorld2D(
+          {(float)GetScreenWidth(), (float)GetScreenHeight()}, camera);
+      TickInput input = {fixedDeltaTime * simulationSpeed,
+                         {viewMin.x, viewMin.y, viewMax.x - viewMin.x,
+                          viewMax.y - viewMin.y},
+                         selectedId};
+      if (rewind) {
+        // A replay runs on the recorded inputs so that it matches the past
+        if (replaying) {
+          input = rewind->GetInput(world.tickCount);
+        }
+        rewind->BeginTick(world, input);
       }
+      const auto tickStart = std::chrono::steady_clock::now();
+      runTick(input);
+      if (options.soak) {
+        soak.Record(world,
+                    std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - tickStart)
+                        .count(),
+                    frameArena);
+      }
+      selectedCreature = selectedCreature ? world.Find(selectedId) : nullptr;
 
-      // Remove consumed food
-      foods.erase(std::remove_if(foods.begin(), foods.end(),
-                                 [](const Food &f) { return f.IsConsumed(); }),
-                  foods.end());
+      snapshots.Publish(world, world.tickCount);
+      sharedExport.Publish(world);
+      if (!replaying) {
+        trajectory.Record(world);
+      }
+      if (options.perfCounters && !replaying) {
+        profile.Add(world);
+      }
 
-      // Remove dead creatures and track total creatures
-      creatures.erase(
-          std::remove_if(creatures.begin(), creatures.end(),
-                         [](const Creature &c) { return !c.IsAlive(); }),
-          creatures.end());
+      if (recorder && !replaying &&
+          recorder->BeginFrame(world.simulationTime)) {
+        BeginMode2D(recordCamera);
+        DrawWorld(world, SortByAge(creatures, frameArena), frameArena);
+        EndMode2D();
+        recorder->EndFrame();
+      }
 
       // Update total creatures ever lived during creature updates
       for (const auto &creature : creatures) {
-        if (creature.GetAge() <= fixedDeltaTime * simulationSpeed) {
+        if (!replaying &&
+            creature.GetAge() <= fixedDeltaTime * simulationSpeed) {
           totalCreaturesEverLived++;
         }
       }
@@ -385,50 +1031,25 @@ int main() {
       accumulator -= fixedDeltaTime;
     }
 
-    BeginDrawing();
-    ClearBackground(Color{10, 10, 10, 255}); // Dark background
-    BeginMode2D(camera);
-
-    // Draw world border using current window size
-    // Draw world border with gradient
-    Color borderColor = ColorAlpha(LIGHTGRAY, 0.3f);
-    DrawRectangleLinesEx(
-        Rectangle{0, 0, (float)GetScreenWidth(), (float)GetScreenHeight()}, 2,
-        borderColor);
-
-    // Draw grid dots
-    int gridSpacing = 50; // Adjust for dot density
-    Color dotColor = ColorAlpha(GRAY, 0.2f);
-    for (int x = 0; x < GetScreenWidth(); x += gridSpacing) {
-      for (int y = 0; y < GetScreenHeight(); y += gridSpacing) {
-        DrawCircle(x, y, 2, dotColor);
-      }
+    // A soak outlasts any one population
+    if (options.soak && creatures.empty()) {
+      Populate(world, options, screenWidth, screenHeight, false);
+      soak.NoteRestart();
     }
 
-    // Draw food
-    for (const auto &food : foods) {
-      food.Draw();
+    if (options.headless) {
+      frameArena.Reset();
+      continue;
     }
 
-    // Sort creatures by age for rank
-    std::vector<std::reference_wrapper<const Creature>> ranked_creatures(
-        creatures.begin(), creatures.end());
-    std::sort(ranked_creatures.begin(), ranked_creatures.end(),
-              [](const Creature &a, const Creature &b) {
-                return a.GetAge() > b.GetAge();
-              });
+    BeginDrawing();
+    ClearBackground(Color{10, 10, 10, 255}); // Dark background
+    BeginMode2D(camera);
 
-    // Draw creatures with rank
-    for (const auto &creature : creatures) {
-      // Find creature's rank
-      auto it = std::find_if(
-          ranked_creatures.begin(), ranked_creatures.end(),
-          [&creature](const std::reference_wrapper<const Creature> &ref) {
-            return &ref.get() == &creature;
-          });
-      int rank = std::distance(ranked_creatures.begin(), it) + 1;
-      creature.Draw(rank, creatures);
-    }
+    // Sort creatures by age for rank; the leaderboard reuses this order
+    ArenaVector<ConstCreatureRef> ranked_creatures =
+        SortByAge(creatures, frameArena);
+    DrawWorld(world, ranked_creatures, frameArena);
 
     EndMode2D();
 
@@ -437,6 +1058,32 @@ int main() {
     DrawText(TextFormat("Zoom: %.2fx", camera.zoom), 10, 50, 20, WHITE);
     DrawText(TextFormat("Sim Speed: %.2fx", simulationSpeed), 10, 70, 20,
              DARKGRAY);
+    DrawText(TextFormat("Founder Lineages: %d",
+                        world.lineage.GetSurvivingFounderCount()),
+             10, 90, 20, DARKGRAY);
+    if (AllocCounter::ENABLED) {
+      DrawText(TextFormat("Allocs/frame: %llu",
+                          (unsigned long long)lastFrameAllocations),
+               10, 110, 20, DARKGRAY);
+    }
+    if (world.multiRate) {
+      DrawText(TextFormat("Tiers: %u full / %u near / %u far",
+                          world.tierCounts[(int)ActivityTier::FOCUS],
+                          world.tierCounts[(int)ActivityTier::NEAR],
+                          world.tierCounts[(int)ActivityTier::FAR]),
+               10, 130, 20, DARKGRAY);
+    }
+    if (rewind) {
+      float behind = (rewind->GetLiveTick() - world.tickCount) *
+                     Constants::PHYSICS_TIMESTEP;
+      float kept = (rewind->GetLiveTick() - rewind->GetOldestTick()) *
+                   Constants::PHYSICS_TIMESTEP;
+      DrawText(rewind->IsReplaying(world)
+                   ? TextFormat("REPLAY: %.1fs behind live", behind)
+                   : TextFormat("Rewind: %.0fs kept in %.1f MB", kept,
+                                rewind->GetMemoryBytes() / 1048576.0f),
+               10, 150, 20, rewind->IsReplaying(world) ? ORANGE : DARKGRAY);
+    }
 
     // Draw keybinds
     const int KEYBIND_Y = GetScreenHeight() - 250;
@@ -469,14 +1116,16 @@ int main() {
     DrawText("R: Reset Sim Speed", KEYBIND_X,
              KEYBIND_Y + KEYBIND_LINE_HEIGHT * 8, KEYBIND_FONT_SIZE,
              keybindColor);
+    if (rewind) {
+      DrawText("[ / ]: Rewind / Forward 5s", KEYBIND_X,
+               KEYBIND_Y + KEYBIND_LINE_HEIGHT * 9, KEYBIND_FONT_SIZE,
+               keybindColor);
+      DrawText("BACKSPACE: Back to Live", KEYBIND_X,
+               KEYBIND_Y + KEYBIND_LINE_HEIGHT * 10, KEYBIND_FONT_SIZE,
+               keybindColor);
+    }
 
-    // Sort creatures by age
-    std::vector<std::reference_wrapper<const Creature>> sorted_creatures(
-        creatures.begin(), creatures.end());
-    std::sort(sorted_creatures.begin(), sorted_creatures.end(),
-              [](const Creature &a, const Creature &b) {
-                return a.GetAge() > b.GetAge();
-              });
+    const ArenaVector<ConstCreatureRef> &sorted_creatures = ranked_creatures;
 
     // Draw leaderboard
     const int BOARD_WIDTH = 250;
@@ -521,11 +1170,25 @@ int main() {
                    80, // Adjust positioning for full width usage
                BOARD_PADDING + HEADER_HEIGHT + (i * ENTRY_HEIGHT), 12, WHITE);
     }
+
+    // Draw trait distributions under the leaderboard
+    DrawTraitPanel(world.traitStats, BOARD_X, BOARD_PADDING * 2 + BOARD_HEIGHT,
+                   BOARD_WIDTH);
     EndDrawing();
+
+    frameArena.Reset();
+    lastFrameAllocations = AllocCounter::GetCount() - frameAllocationsStart;
+  }
+
+  // Finish writing any frames still queued for encoding
+  recorder.reset();
+  if (options.perfCounters) {
+    profile.Log("Run", perfCounters);
   }
+  const bool soakPassed = !options.soak || soak.Report();
 
   // Game over handling
-  if (creatures.empty()) {
+  if (creatures.empty() && !options.headless) {
     gameOver = true;
 
     // Create ranked_creatures vector if creatures is empty
@@ -540,16 +1203,17 @@ int main() {
     // Restart option
     if (IsKeyPressed(KEY_ENTER)) {
       // Reset everything
-      creatures.clear();
-      foods.clear();
+      world.Clear();
+      if (options.foodField) {
+        world.foodField.Reset((float)screenWidth, (float)screenHeight);
+      }
+      if (rewind) {
+        rewind->Clear();
+      }
       selectedCreature = nullptr;
 
       // Repopulate
-      for (int i = 0; i < Constants::INITIAL_CREATURE_COUNT; i++) {
-        Vector2 pos = {(float)GetRandomValue(0, screenWidth),
-                       (float)GetRandomValue(0, screenHeight)};
-        creatures.emplace_back(pos, Constants::INITIAL_CREATURE_SIZE);
-      }
+      Populate(world, options, screenWidth, screenHeight, true);
 
       // Reset simulation variables
       simulationSpeed = 1.0f;
@@ -567,5 +1231,5 @@ int main() {
   }
 
   CloseWindow();
-  return 0;
+  return soakPassed ? 0 : 1;
 }
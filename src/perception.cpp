@@ -0,0 +1,253 @@
+#include "perception.h"
+#include "constants.h"
+#include "world.h"
+#include <algorithm>
+#include <cmath>
+
+const int Senses::NEAREST;
+
+namespace {
+// Where a creature looks from, precomputed once per creature
+struct Viewpoint {
+  Vector2 position;
+  Vector2 facing; // Unit vector along the creature's rotation
+  float touch;
+  float range;
+  float cosHalfFov;
+};
+
+Viewpoint ViewFrom(const Creature &creature) {
+  float radians = creature.GetRotation() * DEG2RAD;
+  Viewpoint view;
+  view.position = creature.GetPosition();
+  view.facing = {cosf(radians), sinf(radians)};
+  view.range = Constants::PERCEPTION_RANGE;
+  view.touch = std::min(creature.GetSize() * Constants::TOUCH_RADIUS_SCALE,
+                        view.range);
+  view.cosHalfFov = cosf(Constants::PERCEPTION_FOV * 0.5f * DEG2RAD);
+  return view;
+}
+
+// Adds the object to a nearest-first list if it is perceived and near
+// enough. Ties break on index so every traversal order agrees.
+void Consider(const Viewpoint &view, Vector2 position, uint32_t index,
+              SensedObject *list, uint8_t &count) {
+  float dx = position.x - view.position.x;
+  float dy = position.y - view.position.y;
+  float squared = dx * dx + dy * dy;
+  if (squared > view.range * view.range) {
+    return;
+  }
+  float distance = sqrtf(squared);
+  float ahead = dx * view.facing.x + dy * view.facing.y;
+  if (distance > view.touch && ahead < distance * view.cosHalfFov) {
+    return; // Outside the field of view
+  }
+
+  int slot = count;
+  while (slot > 0 && (list[slot - 1].distance > distance ||
+                      (list[slot - 1].distance == distance &&
+                       list[slot - 1].index > index))) {
+    slot--;
+  }
+  if (slot >= Senses::NEAREST) {
+    return;
+  }
+  int last = std::min((int)count, Senses::NEAREST - 1);
+  for (int i = last; i > slot; i--) {
+    list[i] = list[i - 1];
+  }
+  // Positive bearings are to the creature's right (screen y points down)
+  float side = dy * view.facing.x - dx * view.facing.y;
+  list[slot] = SensedObject{index, distance, atan2f(side, ahead)};
+  if (count < Senses::NEAREST) {
+    count++;
+  }
+}
+
+// Adds the object to an unordered list if it is closer than radius
+void ConsiderNear(Vector2 centre, float radius, Vector2 position,
+                  uint32_t index, std::vector<SensedObject> &nearby) {
+  float dx = position.x - centre.x;
+  float dy = position.y - centre.y;
+  float squared = dx * dx + dy * dy;
+  if (squared < radius * radius) {
+    nearby.push_back(SensedObject{index, sqrtf(squared), 0.0f});
+  }
+}
+
+// Nearest first, ties broken on index as in Consider
+void SortNearestFirst(std::vector<SensedObject> &nearby) {
+  std::sort(nearby.begin(), nearby.end(),
+            [](const SensedObject &a, const SensedObject &b) {
+              return a.distance != b.distance ? a.distance < b.distance
+                                              : a.index < b.index;
+            });
+}
+} // namespace
+
+int Perception::CellOf(Vector2 position) const {
+  int column = (int)((position.x - origin.x) / Constants::PERCEPTION_RANGE);
+  int row = (int)((position.y - origin.y) / Constants::PERCEPTION_RANGE);
+  return row * columns + column;
+}
+
+template <typename T>
+void Perception::Bin(Grid &grid, const std::vector<T> &objects,
+                     World &world) {
+  // Counting sort of object indices by cell, in tick-arena memory
+  int cells = columns * rows;
+  grid.cellStart = world.tickArena.AllocateArray<uint32_t>(cells + 1);
+  grid.entries = world.tickArena.AllocateArray<uint32_t>(objects.size());
+  grid.positions = world.tickArena.AllocateArray<Vector2>(objects.size());
+  std::fill(grid.cellStart, grid.cellStart + cells + 1, 0);
+  for (const auto &object : objects) {
+    grid.cellStart[CellOf(object.GetPosition()) + 1]++;
+  }
+  for (int cell = 0; cell < cells; cell++) {
+    grid.cellStart[cell + 1] += grid.cellStart[cell];
+  }
+  uint32_t *next = world.tickArena.AllocateArray<uint32_t>(cells);
+  std::copy(grid.cellStart, grid.cellStart + cells, next);
+  for (uint32_t i = 0; i < objects.size(); i++) {
+    Vector2 position = objects[i].GetPosition();
+    uint32_t slot = next[CellOf(position)]++;
+    grid.entries[slot] = i;
+    grid.positions[slot] = position;
+  }
+}
+
+template <bool FIELD> void Perception::Update(World &world) {
+  const std::vector<Creature> &creatures = world.creatures;
+  const std::vector<Food> &foods = world.foods;
+  senses.resize(creatures.size());
+  if (creatures.empty()) {
+    return;
+  }
+
+  // Cells as wide as the sensing range, so everything in range of a
+  // creature lies in the 3x3 block of cells around its own
+  Vector2 low = creatures[0].GetPosition();
+  Vector2 high = low;
+  auto extend = [&](Vector2 position) {
+    low.x = std::min(low.x, position.x);
+    low.y = std::min(low.y, position.y);
+    high.x = std::max(high.x, position.x);
+    high.y = std::max(high.y, position.y);
+  };
+  for (const auto &creature : creatures) {
+    extend(creature.GetPosition());
+  }
+  if (!FIELD) {
+    for (const auto &food : foods) {
+      extend(food.GetPosition());
+    }
+  }
+  origin = low;
+  columns = (int)((high.x - low.x) / Constants::PERCEPTION_RANGE) + 1;
+  rows = (int)((high.y - low.y) / Constants::PERCEPTION_RANGE) + 1;
+  if (!FIELD) {
+    Bin(foodGrid, foods, world);
+  }
+  Bin(creatureGrid, creatures, world);
+
+  // Visit creatures cell by cell so that neighbouring searches reuse the
+  // same cached grid entries
+  for (uint32_t sorted = 0; sorted < creatures.size(); sorted++) {
+    uint32_t i = creatureGrid.entries[sorted];
+    if (!world.IsActive(i)) {
+      continue; // Sitting this Step out; nothing will read its senses
+    }
+    Viewpoint view = ViewFrom(creatures[i]);
+    Senses &sensed = senses[i];
+    sensed.foodCount = 0;
+    sensed.creatureCount = 0;
+    sensed.foodScent =
+        FIELD ? world.foodField.GetGradient(view.position) : Vector2{0, 0};
+
+    int cell = CellOf(view.position);
+    int column = cell % columns;
+    int row = cell / columns;
+    for (int y = std::max(row - 1, 0); y <= std::min(row + 1, rows - 1); y++) {
+      for (int x = std::max(column - 1, 0);
+           x <= std::min(column + 1, columns - 1); x++) {
+        int neighbour = y * columns + x;
+        if (!FIELD) {
+          for (uint32_t e = foodGrid.cellStart[neighbour];
+               e < foodGrid.cellStart[neighbour + 1]; e++) {
+            Consider(view, foodGrid.positions[e], foodGrid.entries[e],
+                     sensed.foods, sensed.foodCount);
+          }
+        }
+        for (uint32_t e = creatureGrid.cellStart[neighbour];
+             e < creatureGrid.cellStart[neighbour + 1]; e++) {
+          uint32_t other = creatureGrid.entries[e];
+          if (other != i) {
+            Consider(view, creatureGrid.positions[e], other,
+                     sensed.creatures, sensed.creatureCount);
+          }
+        }
+      }
+    }
+  }
+}
+
+template void Perception::Update<false>(World &world);
+template void Perception::Update<true>(World &world);
+
+Senses Perception::Scan(const World &world, const Creature &creature) {
+  Viewpoint view = ViewFrom(creature);
+  Senses sensed;
+  if (world.foodField.IsEnabled()) {
+    sensed.foodScent = world.foodField.GetGradient(view.position);
+  }
+  for (uint32_t i = 0; i < world.foods.size(); i++) {
+    Consider(view, world.foods[i].GetPosition(), i, sensed.foods,
+             sensed.foodCount);
+  }
+  for (uint32_t i = 0; i < world.creatures.size(); i++) {
+    if (&world.creatures[i] != &creature) {
+      Consider(view, world.creatures[i].GetPosition(), i, sensed.creatures,
+               sensed.creatureCount);
+    }
+  }
+  return sensed;
+}
+
+const std::vector<SensedObject> &
+Perception::Near(const World &world, uint32_t index, float radius) {
+  nearby.clear();
+  const Vector2 centre = world.creatures[index].GetPosition();
+  const int reach = (int)std::ceil(radius / Constants::PERCEPTION_RANGE);
+  int cell = CellOf(centre);
+  int column = cell % columns;
+  int row = cell / columns;
+  for (int y = std::max(row - reach, 0); y <= std::min(row + reach, rows - 1);
+       y++) {
+    for (int x = std::max(column - reach, 0);
+         x <= std::min(column + reach, columns - 1); x++) {
+      int neighbour = y * columns + x;
+      for (uint32_t e = creatureGrid.cellStart[neighbour];
+           e < creatureGrid.cellStart[neighbour + 1]; e++) {
+        if (creatureGrid.entries[e] != index) {
+          ConsiderNear(centre, radius, creatureGrid.positions[e],
+                       creatureGrid.entries[e], nearby);
+        }
+      }
+    }
+  }
+  SortNearestFirst(nearby);
+  return nearby;
+}
+
+void Perception::ScanNear(const World &world, const Creature &creature,
+                          float radius, std::vector<SensedObject> &nearby) {
+  nearby.clear();
+  for (uint32_t i = 0; i < world.creatures.size(); i++) {
+    if (&world.creatures[i] != &creature) {
+      ConsiderNear(creature.GetPosition(), radius,
+                   world.creatures[i].GetPosition(), i, nearby);
+    }
+  }
+  SortNearestFirst(nearby);
+}
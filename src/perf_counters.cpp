@@ -0,0 +1,107 @@
+#include "perf_counters.h"
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+namespace {
+struct EventConfig {
+  uint32_t type;
+  uint64_t config;
+};
+
+const EventConfig EVENT_CONFIGS[(int)PerfEvent::COUNT] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+int OpenEvent(const EventConfig &event, int group) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                     PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.disabled = group < 0; // The group starts once it is complete
+  // User space only, which perf_event_paranoid up to 2 still allows
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+} // namespace
+
+bool PerfCounters::Open() {
+  Close();
+  leader = OpenEvent(EVENT_CONFIGS[(int)PerfEvent::CYCLES], -1);
+  if (leader < 0) {
+    error = strerror(errno);
+    return false;
+  }
+  files[(int)PerfEvent::CYCLES] = leader;
+  slots[(int)PerfEvent::CYCLES] = counted++;
+  for (int event = 0; event < (int)PerfEvent::COUNT; event++) {
+    if (event == (int)PerfEvent::CYCLES) {
+      continue;
+    }
+    files[event] = OpenEvent(EVENT_CONFIGS[event], leader);
+    if (files[event] >= 0) {
+      slots[event] = counted++;
+    }
+  }
+  ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+}
+
+void PerfCounters::Read(uint64_t values[(int)PerfEvent::COUNT]) const {
+  for (int event = 0; event < (int)PerfEvent::COUNT; event++) {
+    values[event] = 0;
+  }
+  // Event count, time enabled, time running, then one value per event
+  uint64_t buffer[3 + (int)PerfEvent::COUNT];
+  if (leader < 0 ||
+      read(leader, buffer, sizeof(buffer)) < (ssize_t)(3 * sizeof(uint64_t)) ||
+      buffer[0] != (uint64_t)counted || buffer[2] == 0) {
+    return;
+  }
+  double scale = (double)buffer[1] / buffer[2];
+  for (int event = 0; event < (int)PerfEvent::COUNT; event++) {
+    if (slots[event] >= 0) {
+      values[event] = (uint64_t)(buffer[3 + slots[event]] * scale);
+    }
+  }
+}
+#else
+bool PerfCounters::Open() {
+  error = strerror(ENOSYS);
+  return false;
+}
+
+void PerfCounters::Read(uint64_t values[(int)PerfEvent::COUNT]) const {
+  for (int event = 0; event < (int)PerfEvent::COUNT; event++) {
+    values[event] = 0;
+  }
+}
+#endif
+
+void PerfCounters::Close() {
+  for (int event = 0; event < (int)PerfEvent::COUNT; event++) {
+    if (files[event] >= 0) {
+      close(files[event]);
+    }
+    files[event] = -1;
+    slots[event] = -1;
+  }
+  leader = -1;
+  counted = 0;
+}
@@ -0,0 +1,75 @@
+#include "phase_profile.h"
+#include "raylib.h"
+#include <string>
+
+namespace {
+const char *const PHASE_NAMES[(int)TickPhase::COUNT] = {
+    "timers",
+    "food field",
+    "vitals",
+    "perception",
+    "thinking",
+    "feeding",
+    "decision",
+    "interaction",
+    "contagion",
+    "movement",
+    "births and deaths",
+    "reorder",
+};
+} // namespace
+
+void PhaseProfile::Add(const World &world) {
+  steps++;
+  creatureSteps += world.creatures.size();
+  for (int phase = 0; phase < (int)TickPhase::COUNT; phase++) {
+    seconds[phase] += world.phaseSeconds[phase];
+    for (int event = 0; event < (int)PerfEvent::COUNT; event++) {
+      events[phase][event] += world.phaseEvents[phase][event];
+    }
+  }
+}
+
+void PhaseProfile::Log(const char *label, const PerfCounters &counters) const {
+  if (steps == 0) {
+    return;
+  }
+  const double creatures = creatureSteps > 0 ? (double)creatureSteps : 1.0;
+  TraceLog(LOG_INFO, "PERF: %s, %llu steps, %.1f creatures on average", label,
+           (unsigned long long)steps, creatureSteps / (double)steps);
+  if (!counters.IsOpen()) {
+    TraceLog(LOG_INFO, "PERF: %-18s %8s %8s", "phase", "ms/step", "ns/crtr");
+  } else {
+    TraceLog(LOG_INFO, "PERF: %-18s %8s %8s %6s %8s %8s %8s", "phase",
+             "ms/step", "ns/crtr", "IPC", "L1D/crtr", "LLC/crtr", "br/crtr");
+  }
+
+  // Events the CPU does not count show as dashes
+  auto perCreature = [&](int phase, PerfEvent event) -> const char * {
+    if (!counters.IsCounting(event)) {
+      return "-";
+    }
+    return TextFormat("%.1f", events[phase][(int)event] / creatures);
+  };
+  for (int phase = 0; phase < (int)TickPhase::COUNT; phase++) {
+    double msPerStep = seconds[phase] * 1e3 / steps;
+    double nsPerCreature = seconds[phase] * 1e9 / creatures;
+    if (!counters.IsOpen()) {
+      TraceLog(LOG_INFO, "PERF: %-18s %8.3f %8.1f", PHASE_NAMES[phase],
+               msPerStep, nsPerCreature);
+      continue;
+    }
+    uint64_t cycles = events[phase][(int)PerfEvent::CYCLES];
+    uint64_t instructions = events[phase][(int)PerfEvent::INSTRUCTIONS];
+    // TextFormat cycles through a few buffers, so each column gets its own
+    std::string ipc = counters.IsCounting(PerfEvent::INSTRUCTIONS) && cycles > 0
+                          ? TextFormat("%.2f", (double)instructions / cycles)
+                          : "-";
+    std::string l1 = perCreature(phase, PerfEvent::L1D_MISSES);
+    std::string llc = perCreature(phase, PerfEvent::LLC_MISSES);
+    std::string branch = perCreature(phase, PerfEvent::BRANCH_MISSES);
+    TraceLog(LOG_INFO, "PERF: %-18s %8.3f %8.1f %6s %8s %8s %8s",
+             PHASE_NAMES[phase], msPerStep, nsPerCreature, ipc.c_str(),
+             l1.c_str(), llc.c_str(), branch.c_str());
+  }
+}
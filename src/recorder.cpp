@@ -0,0 +1,222 @@
+#include "recorder.h"
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#if defined(__APPLE__)
+#include <OpenGL/gl3.h>
+#else
+#define GL_GLEXT_PROTOTYPES
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+
+Recorder::Recorder(const RecorderConfig &config) : config(config) {
+  mkdir(config.directory.c_str(), 0755);
+  target = LoadRenderTexture(config.width, config.height);
+
+  // Every frame in flight, queued or being encoded holds one slot
+  const int slotCount = config.queueDepth + config.workers;
+  const size_t frameBytes = (size_t)config.width * config.height * 4;
+  pixelBuffers.resize(slotCount);
+  glGenBuffers(slotCount, pixelBuffers.data());
+  for (int i = 0; i < slotCount; i++) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[i]);
+    glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+    freeSlots.push_back(i);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  fences.assign(slotCount, nullptr);
+  mappings.assign(slotCount, nullptr);
+  inFlight.reserve(slotCount);
+  finishedSlots.reserve(slotCount);
+  queue.resize(slotCount);
+
+  flipBuffers.resize(config.workers);
+  for (int i = 0; i < config.workers; i++) {
+    if (config.format == FrameFormat::PNG) {
+      flipBuffers[i].resize(frameBytes);
+    }
+    workers.emplace_back(&Recorder::WorkerLoop, this, i);
+  }
+}
+
+Recorder::~Recorder() {
+  // Flush the frames still on the GPU, then let the workers drain the queue
+  Collect(true);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  jobReady.notify_all();
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  Collect(false);
+
+  glDeleteBuffers((int)pixelBuffers.size(), pixelBuffers.data());
+  UnloadRenderTexture(target);
+  TraceLog(LOG_INFO, "RECORDER: %d frames written, %d dropped, to %s",
+           framesWritten, framesDropped, config.directory.c_str());
+}
+
+bool Recorder::BeginFrame(double simulationTime) {
+  if (simulationTime < nextCaptureTime) {
+    return false;
+  }
+  // A tick longer than the interval jumps over capture times; only the
+  // latest is captured and the rest count as dropped. Frame numbers count
+  // capture times, dropped or not, so they still map to simulation time.
+  uint64_t reached = 0;
+  while (nextCaptureTime <= simulationTime) {
+    nextCaptureTime += config.interval;
+    reached++;
+  }
+  if (reached > 1) {
+    if (!warnedSkipping) {
+      TraceLog(LOG_WARNING,
+               "RECORDER: Ticks are longer than the frame interval; the "
+               "frames they jump over are dropped");
+      warnedSkipping = true;
+    }
+    framesDropped += (int)(reached - 1);
+    nextFrame += reached - 1;
+  }
+
+  // Backpressure: skip the frame rather than wait for the GPU or encoders
+  Collect(false);
+  if (freeSlots.empty()) {
+    framesDropped++;
+    nextFrame++;
+    return false;
+  }
+
+  BeginTextureMode(target);
+  ClearBackground(Color{10, 10, 10, 255});
+  return true;
+}
+
+void Recorder::EndFrame() {
+  EndTextureMode();
+
+  // Queues the copy into the slot's buffer and returns at once. The
+  // texture is RGBA8, so asking for RGBA bytes needs no conversion
+  int slot = freeSlots.back();
+  freeSlots.pop_back();
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, target.id);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[slot]);
+  glReadPixels(0, 0, config.width, config.height, GL_RGBA, GL_UNSIGNED_BYTE,
+               nullptr);
+  fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  inFlight.push_back(Job{slot, nextFrame++});
+}
+
+void Recorder::Collect(bool wait) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (int slot : finishedSlots) {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[slot]);
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      mappings[slot] = nullptr;
+      freeSlots.push_back(slot);
+    }
+    finishedSlots.clear();
+  }
+
+  const size_t frameBytes = (size_t)config.width * config.height * 4;
+  const GLuint64 TIMEOUT = 1000000000; // A second, in nanoseconds
+  size_t ready = 0;
+  for (; ready < inFlight.size(); ready++) {
+    const int slot = inFlight[ready].slot;
+    GLsync fence = static_cast<GLsync>(fences[slot]);
+    if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                         wait ? TIMEOUT : 0) == GL_TIMEOUT_EXPIRED) {
+      break; // Later frames were queued after this one
+    }
+    glDeleteSync(fence);
+    fences[slot] = nullptr;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[slot]);
+    mappings[slot] = static_cast<const unsigned char *>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameBytes, GL_MAP_READ_BIT));
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  if (ready == 0) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < ready; i++) {
+      const Job &job = inFlight[i];
+      if (!mappings[job.slot]) {
+        freeSlots.push_back(job.slot);
+        framesDropped++;
+        continue;
+      }
+      int tail = (queueHead + queueCount) % (int)queue.size();
+      queue[tail] = job;
+      queueCount++;
+    }
+  }
+  inFlight.erase(inFlight.begin(), inFlight.begin() + ready);
+  jobReady.notify_all();
+}
+
+void Recorder::WorkerLoop(int worker) {
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      jobReady.wait(lock, [this] { return stopping || queueCount > 0; });
+      if (queueCount == 0) {
+        return; // Stopping and fully drained
+      }
+      job = queue[queueHead];
+      queueHead = (queueHead + 1) % (int)queue.size();
+      queueCount--;
+    }
+
+    Encode(job, flipBuffers[worker]);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    finishedSlots.push_back(job.slot);
+    framesWritten++;
+  }
+}
+
+void Recorder::Encode(const Job &job, std::vector<unsigned char> &flipped) {
+  char path[512];
+  const unsigned char *pixels = mappings[job.slot];
+  const size_t rowBytes = (size_t)config.width * 4;
+
+  // Read back bottom-up; both formats are written top-down
+  if (config.format == FrameFormat::PNG) {
+    snprintf(path, sizeof(path), "%s/frame_%06llu.png",
+             config.directory.c_str(), (unsigned long long)job.frame);
+    for (int y = 0; y < config.height; y++) {
+      std::memcpy(&flipped[y * rowBytes],
+                  pixels + (size_t)(config.height - 1 - y) * rowBytes,
+                  rowBytes);
+    }
+    Image image = {flipped.data(), config.width, config.height, 1,
+                   PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    ExportImage(image, path);
+  } else {
+    // Headerless RGBA8, e.g. for ffmpeg -f rawvideo -pix_fmt rgba
+    snprintf(path, sizeof(path), "%s/frame_%06llu.rgba",
+             config.directory.c_str(), (unsigned long long)job.frame);
+    FILE *file = fopen(path, "wb");
+    if (file) {
+      for (int y = config.height - 1; y >= 0; y--) {
+        fwrite(pixels + (size_t)y * rowBytes, 1, rowBytes, file);
+      }
+      fclose(file);
+    }
+  }
+}
+
+int Recorder::GetFramesWritten() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return framesWritten;
+}
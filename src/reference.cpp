@@ -0,0 +1,590 @@
+#include "constants.h"
+#include "creature.h"
+#include "perception.h"
+#include "world.h"
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+// The reference engine. Every rule of a creature's tick is written out here
+// a second time as plain scalar code, so that a change to Step's phase
+// methods that is not made here too shows up in the Differential harness
+// instead of being shared by both engines. The two share only what is not a
+// rule of the tick: the timer wheel (FireTimers, OnTimer and StartTimer),
+// admitting births and removing the dead (SettleBirthsAndDeaths), the
+// storage sort, and the random streams. A reference world is never tiled,
+// so ghosts are skipped and nothing is claimed.
+struct Creature::Reference {
+  // Something a creature would like to do with another, with both ends'
+  // ids for ordering
+  struct Proposal {
+    float distance;
+    uint32_t lowId;
+    uint32_t highId;
+    uint32_t proposerId;
+    uint32_t proposer; // Indices into World::creatures
+    uint32_t partner;
+    InteractionKind kind;
+  };
+
+  static float Clamp(float value, float min, float max) {
+    return value < min ? min : value > max ? max : value;
+  }
+  static bool Wants(const BrainOutput *thoughts, BrainLayout::Output intent) {
+    return !thoughts || thoughts->values[intent] > 0.0f;
+  }
+
+  static void Vitals(Creature &c, float deltaTime) {
+    c.age += deltaTime;
+    float burnRate = Constants::ENERGY_CONSUMPTION_RATE * c.metabolism;
+    float before = c.energy;
+    c.energy -= deltaTime * burnRate;
+    // Starving costs health only for the part of the step spent at zero
+    if (c.energy < 0) {
+      float starving = before > 0 ? -c.energy / burnRate : deltaTime;
+      c.health -= starving * Constants::HEALTH_DECAY_RATE;
+    }
+  }
+
+  static BrainInput Sense(const Creature &c, const Senses &senses) {
+    using namespace BrainLayout;
+    const float range = Constants::PERCEPTION_RANGE;
+    BrainInput input = {};
+    if (senses.foodCount > 0) {
+      const SensedObject &food = senses.foods[0];
+      input.values[FOOD_AHEAD] = cosf(food.bearing) * food.distance / range;
+      input.values[FOOD_SIDE] = sinf(food.bearing) * food.distance / range;
+    } else if (senses.foodScent.x != 0.0f || senses.foodScent.y != 0.0f) {
+      float bearing = atan2f(senses.foodScent.y, senses.foodScent.x) -
+                      c.GetRotation() * DEG2RAD;
+      float distance = Constants::FIELD_SCENT_RADIUS / range;
+      input.values[FOOD_AHEAD] = cosf(bearing) * distance;
+      input.values[FOOD_SIDE] = sinf(bearing) * distance;
+    }
+    if (senses.creatureCount > 0) {
+      const SensedObject &other = senses.creatures[0];
+      input.values[CREATURE_AHEAD] =
+          cosf(other.bearing) * other.distance / range;
+      input.values[CREATURE_SIDE] =
+          sinf(other.bearing) * other.distance / range;
+    }
+    input.values[ENERGY] = c.energy / Constants::INITIAL_ENERGY;
+    input.values[HEALTH] = c.health / Constants::INITIAL_HEALTH;
+    input.values[AGE] = std::min(c.age / Constants::BRAIN_AGE_SCALE, 1.0f);
+    input.values[BIAS] = 1.0f;
+    return input;
+  }
+
+  static void Steer(Creature &c, const BrainOutput &thoughts) {
+    float radians = c.GetRotation() * DEG2RAD;
+    float ahead = thoughts.values[BrainLayout::STEER_AHEAD];
+    float side = thoughts.values[BrainLayout::STEER_SIDE];
+    c.velocity.x += (ahead * cosf(radians) - side * sinf(radians)) *
+                    Constants::BRAIN_STEER_FORCE;
+    c.velocity.y += (ahead * sinf(radians) + side * cosf(radians)) *
+                    Constants::BRAIN_STEER_FORCE;
+  }
+
+  static void Wander(Creature &c, RandomStream random,
+                     const BrainOutput *thoughts) {
+    if (thoughts) {
+      Steer(c, *thoughts);
+      return;
+    }
+    c.velocity.x += (float)random.Range(-20, 20) / 100.0f;
+    c.velocity.y += (float)random.Range(-20, 20) / 100.0f;
+  }
+
+  // Eating grows the creature, slowing it and making it stronger
+  static void StartEating(Creature &c, World &world) {
+    if (c.state != CreatureState::EATING) {
+      c.StartTimer(TimerKind::EATING_DONE, Constants::EATING_DURATION, world);
+    }
+    c.state = CreatureState::EATING;
+    c.velocity = Vector2{0, 0};
+  }
+
+  static void EatItem(Creature &c, World &world) {
+    c.energy += Constants::FOOD_ENERGY_VALUE;
+    if (c.energy > Constants::INITIAL_ENERGY) {
+      c.energy = Constants::INITIAL_ENERGY;
+    }
+    TraitSample before = c.GetTraits();
+    c.size += Constants::FOOD_GROW_SIZE;
+    c.speed =
+        Clamp(c.speed * 0.95f, Constants::MIN_SPEED, Constants::MAX_SPEED);
+    c.strength = Clamp(c.strength * 1.05f, Constants::MIN_STRENGTH,
+                       Constants::MAX_STRENGTH);
+    world.traitStats.Replace(before, c.GetTraits());
+    StartEating(c, world);
+  }
+
+  static void Graze(Creature &c, World &world, const Senses &senses,
+                    float deltaTime, const BrainOutput *thoughts) {
+    float eaten = world.foodField.Eat(
+        c.position, Constants::FIELD_BITE_RATE * deltaTime);
+    if (eaten > 0.0f) {
+      c.energy = std::min(c.energy + eaten * Constants::FOOD_ENERGY_VALUE,
+                          Constants::INITIAL_ENERGY);
+      TraitSample before = c.GetTraits();
+      c.size += Constants::FOOD_GROW_SIZE * eaten;
+      c.speed = Clamp(c.speed * powf(0.95f, eaten), Constants::MIN_SPEED,
+                      Constants::MAX_SPEED);
+      c.strength = Clamp(c.strength * powf(1.05f, eaten),
+                         Constants::MIN_STRENGTH, Constants::MAX_STRENGTH);
+      world.traitStats.Replace(before, c.GetTraits());
+    }
+    if (eaten >= Constants::FIELD_FOOD_THRESHOLD * 0.1f) {
+      StartEating(c, world);
+      return;
+    }
+    if (c.state != CreatureState::HUNTING) {
+      return;
+    }
+
+    // Uphill along the scent, or wherever the brain steers
+    float scent = sqrtf(senses.foodScent.x * senses.foodScent.x +
+                        senses.foodScent.y * senses.foodScent.y);
+    if (thoughts) {
+      Steer(c, *thoughts);
+    } else if (scent > 0.0f) {
+      c.velocity.x += senses.foodScent.x / scent * Constants::FOOD_SEEK_FORCE;
+      c.velocity.y += senses.foodScent.y / scent * Constants::FOOD_SEEK_FORCE;
+    } else {
+      Wander(c, world.RandomFor(c.id, RandomPurpose::SEARCH), thoughts);
+    }
+  }
+
+  // HUNTING and EATING: eat the first uneaten item within reach, nearest
+  // first, and otherwise head for the nearest
+  static void Feed(Creature &c, World &world, const Senses &senses,
+                   float deltaTime, const BrainOutput *thoughts) {
+    if (world.foodField.IsEnabled()) {
+      Graze(c, world, senses, deltaTime, thoughts);
+      return;
+    }
+    bool foundFood = false;
+    Vector2 nearestFoodPos = {0, 0};
+    for (int i = 0; i < senses.foodCount; i++) {
+      Food &food = world.foods[senses.foods[i].index];
+      if (food.IsConsumed()) {
+        continue;
+      }
+      if (!foundFood) {
+        nearestFoodPos = food.GetPosition();
+        foundFood = true;
+      }
+      if (senses.foods[i].distance < (c.size + Food::SIZE) * 0.5f) {
+        food.Consume();
+        EatItem(c, world);
+        break;
+      }
+    }
+
+    if (c.state != CreatureState::HUNTING) {
+      return;
+    }
+    if (thoughts) {
+      Steer(c, *thoughts);
+    } else if (foundFood) {
+      float dx = nearestFoodPos.x - c.position.x;
+      float dy = nearestFoodPos.y - c.position.y;
+      float dist = sqrt(dx * dx + dy * dy);
+      if (dist > 0) {
+        c.velocity.x += (dx / dist) * Constants::FOOD_SEEK_FORCE;
+        c.velocity.y += (dy / dist) * Constants::FOOD_SEEK_FORCE;
+      }
+    } else {
+      Wander(c, world.RandomFor(c.id, RandomPurpose::SEARCH), thoughts);
+    }
+  }
+
+  static float FightOdds(const Creature &c, const Creature &opponent,
+                         const World &world) {
+    float odds = 0.5f + (c.strength - opponent.strength) /
+                            (Constants::MAX_STRENGTH * 2);
+    RandomStream random =
+        world.RandomFor(c.id, RandomPurpose::FIGHT_ODDS, opponent.id);
+    odds += random.Range(-10, 10) / 100.0f;
+    return Clamp(odds, 0.0f, 1.0f);
+  }
+
+  // Every state but EATING: picks the next state, and proposes fights and
+  // matings with the creatures sensed, nearest first. Returns whether the
+  // creature has just fallen sick.
+  static bool Decide(Creature &c, uint32_t index, World &world,
+                     const Senses &senses, const BrainOutput *thoughts,
+                     std::vector<Proposal> &proposals) {
+    const CreatureState previousState = c.state;
+    int proposed = 0;
+    auto propose = [&](InteractionKind kind, int sensed) {
+      const SensedObject &other = senses.creatures[sensed];
+      uint32_t a = c.id;
+      uint32_t b = world.creatures[other.index].id;
+      proposals.push_back(Proposal{other.distance, std::min(a, b),
+                                   std::max(a, b), a, index, other.index,
+                                   kind});
+      proposed++;
+    };
+
+    if (c.energy < Constants::HUNGRY_THRESHOLD) {
+      bool foundFood = false;
+      if (world.foodField.IsEnabled()) {
+        foundFood = world.foodField.Sample(c.position) >
+                        Constants::FIELD_FOOD_THRESHOLD ||
+                    senses.foodScent.x != 0.0f || senses.foodScent.y != 0.0f;
+      } else {
+        for (int i = 0; i < senses.foodCount && !foundFood; i++) {
+          foundFood = !world.foods[senses.foods[i].index].IsConsumed();
+        }
+      }
+
+      // With no food about, rob a creature that is eating
+      if (world.fightingEnabled && !foundFood && c.canFight &&
+          Wants(thoughts, BrainLayout::FIGHT)) {
+        for (int i = 0; i < senses.creatureCount &&
+                        proposed < InteractionStage::MAX_PROPOSALS;
+             i++) {
+          const Creature &other = world.creatures[senses.creatures[i].index];
+          if (other.state == CreatureState::EATING &&
+              senses.creatures[i].distance < c.size * 2 &&
+              FightOdds(c, other, world) > 0.5f) {
+            propose(InteractionKind::FIGHT_OVER_FOOD, i);
+          }
+        }
+      }
+      c.state = CreatureState::HUNTING;
+    } else if (c.health < Constants::CRITICAL_HEALTH) {
+      c.state = CreatureState::SICK;
+    } else if (c.canMate && Wants(thoughts, BrainLayout::MATE) &&
+               c.energy > Constants::MATING_ENERGY &&
+               c.age > Constants::MATING_AGE) {
+      // A female fights off a male she could beat rather than mating
+      for (int i = 0; i < senses.creatureCount &&
+                      proposed < InteractionStage::MAX_PROPOSALS;
+           i++) {
+        const Creature &other = world.creatures[senses.creatures[i].index];
+        if (other.energy > Constants::MATING_ENERGY &&
+            other.age > Constants::MATING_AGE && other.isMale != c.isMale &&
+            senses.creatures[i].distance < c.size * 3) {
+          bool fight = world.fightingEnabled && !c.isMale && other.isMale &&
+                       c.canFight && Wants(thoughts, BrainLayout::FIGHT) &&
+                       FightOdds(c, other, world) > 0.5f;
+          propose(fight ? InteractionKind::FIGHT_OVER_MATE
+                        : InteractionKind::MATE,
+                  i);
+        }
+      }
+    } else if (c.health < Constants::LOW_HEALTH) {
+      c.state = CreatureState::SICK;
+    } else {
+      c.state = CreatureState::WANDERING;
+    }
+    return c.state == CreatureState::SICK &&
+           previousState != CreatureState::SICK;
+  }
+
+  static void FightResult(Creature &c, bool won) {
+    if (won) {
+      c.energy += 10.0f;
+      c.health += 5.0f;
+    } else {
+      c.energy -= 15.0f;
+      c.health -= 10.0f;
+    }
+  }
+
+  // The proposer's side of a fight or mating
+  static void Outcome(Creature &c, InteractionKind kind, bool won,
+                      World &world) {
+    if (kind == InteractionKind::MATE) {
+      c.energy *= 0.7f;
+      c.state = CreatureState::MATING;
+      c.StartTimer(TimerKind::MATING_COOLDOWN, Constants::MATING_COOLDOWN,
+                   world);
+      return;
+    }
+    c.state = CreatureState::FIGHTING;
+    FightResult(c, won);
+    c.StartTimer(TimerKind::FIGHT_COOLDOWN, Constants::FIGHT_COOLDOWN, world);
+    // A hungry winner gets most of the food it fought over
+    if (kind == InteractionKind::FIGHT_OVER_FOOD && c.energy < 0) {
+      c.energy += Constants::FOOD_ENERGY_VALUE * 0.8f;
+    }
+  }
+
+  static void Interact(const Proposal &pair, World &world) {
+    Creature &c = world.creatures[pair.proposer];
+    Creature &other = world.creatures[pair.partner];
+    RandomStream random = world.RandomFor(c.id, RandomPurpose::INTERACTION);
+    if (pair.kind != InteractionKind::MATE) {
+      bool won = random.Range(0, 100) / 100.0f < FightOdds(c, other, world);
+      Outcome(c, pair.kind, won, world);
+      FightResult(other, !won);
+      return;
+    }
+
+    // The child takes the parents' mean traits, each varied by up to 10%,
+    // and in brain mode a mix of their genomes
+    Vector2 a = c.position;
+    Vector2 b = other.position;
+    float mixStrength = (c.strength + other.strength) / 2;
+    float mixSpeed = (c.speed + other.speed) / 2;
+    float mixMetabolism = (c.metabolism + other.metabolism) / 2;
+    mixStrength *= (1.0f + (random.Range(-10, 10) / 100.0f));
+    mixSpeed *= (1.0f + (random.Range(-10, 10) / 100.0f));
+    mixMetabolism *= (1.0f + (random.Range(-10, 10) / 100.0f));
+    bool isMale = random.Range(0, 1) == 1;
+    world.births.push_back(
+        Creature(Vector2{(a.x + b.x) / 2, (a.y + b.y) / 2}, c.size, isMale));
+    world.birthParents.push_back(std::make_pair(c.id, other.id));
+    Creature &child = world.births.back();
+    child.strength =
+        Clamp(mixStrength, Constants::MIN_STRENGTH, Constants::MAX_STRENGTH);
+    child.speed = Clamp(mixSpeed + 0.1f, Constants::MIN_SPEED,
+                        Constants::MAX_SPEED);
+    child.metabolism = Clamp(mixMetabolism, Constants::MIN_METABOLISM,
+                             Constants::MAX_METABOLISM);
+    if (world.brainsEnabled) {
+      world.birthGenomes.push_back(
+          Genome::Inherit(world.brains.GetGenome(pair.proposer),
+                          world.brains.GetGenome(pair.partner), random));
+    }
+    Outcome(c, pair.kind, true, world);
+  }
+
+  // Closest pairs first, then by the ids at either end
+  static bool Before(const Proposal &x, const Proposal &y) {
+    if (x.distance != y.distance) {
+      return x.distance < y.distance;
+    }
+    if (x.lowId != y.lowId) {
+      return x.lowId < y.lowId;
+    }
+    if (x.highId != y.highId) {
+      return x.highId < y.highId;
+    }
+    return x.proposerId < y.proposerId;
+  }
+
+  // Each creature takes part in at most one interaction a tick: pairs are
+  // taken greedily while both ends are free. Recoveries are started first.
+  static void Settle(World &world, std::vector<Proposal> &proposals,
+                     const std::vector<uint32_t> &fellSick) {
+    std::sort(proposals.begin(), proposals.end(), Before);
+    std::vector<bool> busy(world.creatures.size(), false);
+    std::vector<Proposal> pairs;
+    for (const Proposal &proposal : proposals) {
+      if (!busy[proposal.proposer] && !busy[proposal.partner]) {
+        busy[proposal.proposer] = true;
+        busy[proposal.partner] = true;
+        pairs.push_back(proposal);
+      }
+    }
+    for (uint32_t i : fellSick) {
+      world.creatures[i].StartTimer(TimerKind::SICK_RECOVERY,
+                                    Constants::SICK_RECOVERY_TIME, world);
+    }
+    for (const Proposal &pair : pairs) {
+      Interact(pair, world);
+    }
+  }
+
+  // SICK: every creature close enough may catch it
+  static void Spread(Creature &c, World &world,
+                     const std::vector<SensedObject> &nearby) {
+    for (const SensedObject &sensed : nearby) {
+      Creature &other = world.creatures[sensed.index];
+      RandomStream random =
+          world.RandomFor(c.id, RandomPurpose::CONTAGION, other.id);
+      if (random.Range(0, 100) >= 10) {
+        continue;
+      }
+      other.health -= 5.0f;
+      if (other.health < Constants::CRITICAL_HEALTH &&
+          other.state != CreatureState::SICK) {
+        other.state = CreatureState::SICK;
+        other.StartTimer(TimerKind::SICK_RECOVERY,
+                         Constants::SICK_RECOVERY_TIME, world);
+      }
+    }
+  }
+
+  static void Move(Creature &c, World &world, float deltaTime,
+                   const BrainOutput *thoughts) {
+    if (c.state == CreatureState::EATING ||
+        c.state == CreatureState::FIGHTING ||
+        c.state == CreatureState::MATING) {
+      c.velocity = Vector2{0, 0};
+      return;
+    }
+    if (c.state != CreatureState::HUNTING) {
+      Wander(c, world.RandomFor(c.id, RandomPurpose::WANDER), thoughts);
+    }
+
+    Vector2 velocity = c.velocity;
+    float speed = sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+    if (speed > Constants::MAX_VELOCITY) {
+      c.velocity.x = (velocity.x / speed) * Constants::MAX_VELOCITY;
+      c.velocity.y = (velocity.y / speed) * Constants::MAX_VELOCITY;
+    }
+    // Bounds are checked before the position is stored, as a compact one
+    // saturates
+    Vector2 next = c.position;
+    next.x += c.velocity.x * deltaTime * Constants::BASE_MOVEMENT_SPEED * speed;
+    next.y += c.velocity.y * deltaTime * Constants::BASE_MOVEMENT_SPEED * speed;
+#ifndef CREATURE_COMPACT
+    if (speed > 0.1f) {
+      c.rotation = atan2f(c.velocity.y, c.velocity.x) * RAD2DEG;
+    }
+#endif
+    const float right = GetScreenWidth() - c.size;
+    const float bottom = GetScreenHeight() - c.size;
+    if (next.x < 0) {
+      next.x = 0;
+      c.velocity.x *= Constants::BOUNDARY_BOUNCE;
+    }
+    if (next.x > right) {
+      next.x = right;
+      c.velocity.x *= -0.8f;
+    }
+    if (next.y < 0) {
+      next.y = 0;
+      c.velocity.y *= -0.8f;
+    }
+    if (next.y > bottom) {
+      next.y = bottom;
+      c.velocity.y *= -0.8f;
+    }
+    c.position = next;
+  }
+
+  // Every creature that took its turn, halted or not
+  static void Recolor(Creature &c) {
+#ifndef CREATURE_COMPACT
+    c.color = c.GetStateColor();
+#else
+    (void)c;
+#endif
+  }
+
+  // Multi-rate updates: the seconds the creature advances this tick, or -1
+  // if it sits this one out and banks the time instead
+  static float TakeTurn(Creature &c, const World &world, float deltaTime) {
+    uint32_t period = 1;
+    if (world.multiRate && c.id != world.focusId &&
+        !CheckCollisionPointRec(c.position, world.focusRegion)) {
+      const float margin = Constants::ACTIVITY_NEAR_MARGIN;
+      const Rectangle &focus = world.focusRegion;
+      Rectangle near = {focus.x - margin, focus.y - margin,
+                        focus.width + margin * 2, focus.height + margin * 2};
+      period = CheckCollisionPointRec(c.position, near)
+                   ? Constants::ACTIVITY_NEAR_PERIOD
+                   : Constants::ACTIVITY_FAR_PERIOD;
+    }
+    if ((world.tickCount + c.id) % period != 0) {
+      c.deferredTime += deltaTime;
+      return -1.0f;
+    }
+    float total = c.deferredTime + deltaTime;
+    c.deferredTime = 0.0f;
+    return total;
+  }
+};
+
+void World::StepReference(float deltaTime) {
+  typedef Creature::Reference Reference;
+  FireTimers(deltaTime);
+  if (foodField.IsEnabled()) {
+    foodField.Advance(deltaTime);
+  }
+
+  const uint32_t count = (uint32_t)creatures.size();
+  std::vector<float> times(count, -1.0f);
+  for (uint32_t i = 0; i < count; i++) {
+    if (!creatures[i].IsGhost()) {
+      times[i] = Reference::TakeTurn(creatures[i], *this, deltaTime);
+    }
+  }
+
+  // Where the order creatures are visited in decides something, Step's is
+  // followed: state by state, in storage order within each, with states as
+  // they stand before the phase
+  std::vector<uint32_t> visiting;
+  auto inState = [&](std::initializer_list<CreatureState> states)
+      -> const std::vector<uint32_t> & {
+    visiting.clear();
+    for (CreatureState state : states) {
+      for (uint32_t i = 0; i < count; i++) {
+        if (times[i] >= 0.0f && creatures[i].GetState() == state) {
+          visiting.push_back(i);
+        }
+      }
+    }
+    return visiting;
+  };
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (times[i] >= 0.0f) {
+      Reference::Vitals(creatures[i], times[i]);
+    }
+  }
+
+  // Senses from a scan of every creature and food, and one brain at a time
+  std::vector<Senses> senses(count);
+  std::vector<BrainOutput> thinking(brainsEnabled ? count : 0);
+  auto thoughtsOf = [&](uint32_t i) -> const BrainOutput * {
+    return brainsEnabled ? &thinking[i] : nullptr;
+  };
+  for (uint32_t i = 0; i < count; i++) {
+    if (times[i] >= 0.0f) {
+      senses[i] = Perception::Scan(*this, creatures[i]);
+      if (brainsEnabled) {
+        thinking[i] = brains.GetGenome(i).Evaluate(
+            Reference::Sense(creatures[i], senses[i]));
+      }
+    }
+  }
+
+  for (uint32_t i :
+       inState({CreatureState::HUNTING, CreatureState::EATING})) {
+    Reference::Feed(creatures[i], *this, senses[i], times[i], thoughtsOf(i));
+  }
+
+  std::vector<Creature::Reference::Proposal> proposals;
+  std::vector<uint32_t> fellSick;
+  for (uint32_t i = 0; i < count; i++) {
+    if (times[i] >= 0.0f &&
+        creatures[i].GetState() != CreatureState::EATING &&
+        Reference::Decide(creatures[i], i, *this, senses[i], thoughtsOf(i),
+                          proposals)) {
+      fellSick.push_back(i);
+    }
+  }
+  Reference::Settle(*this, proposals, fellSick);
+
+  // Only those sick before this phase spread it
+  if (contagionEnabled) {
+    std::vector<SensedObject> nearby;
+    for (uint32_t i : inState({CreatureState::SICK})) {
+      Perception::ScanNear(*this, creatures[i], creatures[i].GetSize() * 2,
+                           nearby);
+      Reference::Spread(creatures[i], *this, nearby);
+    }
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    if (times[i] >= 0.0f) {
+      Reference::Move(creatures[i], *this, times[i], thoughtsOf(i));
+      Reference::Recolor(creatures[i]);
+    }
+  }
+
+  SettleBirthsAndDeaths();
+  if (tickCount % Constants::REORDER_CHECK_INTERVAL == 0) {
+    ReorderStorage();
+  }
+  tickArena.Reset();
+}
@@ -0,0 +1,173 @@
+#include "rewind.h"
+#include "world.h"
+#include <algorithm>
+#include <ctime>
+
+const size_t Rewind::MAX_PENDING;
+
+Rewind::Rewind(size_t budgetBytes, uint32_t interval)
+    : budgetBytes(budgetBytes), interval(std::max(interval, 1u)),
+      seed((uint32_t)time(nullptr)) {
+  worker = std::thread(&Rewind::WorkerLoop, this);
+}
+
+Rewind::~Rewind() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  jobReady.notify_all();
+  worker.join();
+}
+
+void Rewind::Reseed(uint64_t tick) const {
+  SetRandomSeed(seed ^ (uint32_t)(tick * 2654435761u));
+}
+
+void Rewind::BeginTick(World &world, const TickInput &input) {
+  uint64_t tick = world.tickCount;
+  if (tick > liveTick || (tick < liveTick && tick < journalStart)) {
+    Clear(); // The world was replaced behind our back
+  }
+  if (tick % interval == 0) {
+    Reseed(tick);
+  }
+  if (tick < liveTick) {
+    return; // Replaying; the journal already has this tick
+  }
+
+  if (journal.empty()) {
+    journalStart = tick;
+  }
+  journal.push_back(input);
+  liveTick = tick + 1;
+
+  // The world is saved here, while it cannot change; only the compression
+  // is left to the worker. A worker that falls behind costs a keyframe
+  // rather than a stall.
+  if (tick % interval == 0) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (pending.size() < MAX_PENDING) {
+      lock.unlock();
+      Keyframe keyframe;
+      keyframe.tick = tick;
+      world.Save(keyframe.data);
+      lock.lock();
+      pending.push_back(std::move(keyframe));
+      jobReady.notify_one();
+    }
+  }
+  TrimJournal();
+}
+
+void Rewind::TrimJournal() {
+  uint64_t oldest = GetOldestTick();
+  while (!journal.empty() && journalStart < oldest) {
+    journal.pop_front();
+    journalStart++;
+  }
+}
+
+uint64_t Rewind::Seek(World &world, uint64_t tick, const TickFn &runTick) {
+  // Wait for every keyframe taken so far
+  std::vector<uint8_t> compressed;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending.empty() && !compressing; });
+    if (keyframes.empty()) {
+      return world.tickCount;
+    }
+    tick = std::min(std::max(tick, keyframes.front().tick), liveTick);
+    auto it = std::upper_bound(
+        keyframes.begin(), keyframes.end(), tick,
+        [](uint64_t t, const Keyframe &keyframe) { return t < keyframe.tick; });
+    compressed = std::prev(it)->data;
+  }
+
+  int size = 0;
+  unsigned char *data =
+      DecompressData(compressed.data(), (int)compressed.size(), &size);
+  bool loaded = data && world.Load(data, (size_t)size);
+  MemFree(data);
+  if (!loaded) {
+    TraceLog(LOG_WARNING, "REWIND: Could not restore keyframe");
+    Clear();
+    return world.tickCount;
+  }
+
+  while (world.tickCount < tick) {
+    const TickInput &input = GetInput(world.tickCount);
+    BeginTick(world, input);
+    runTick(input);
+  }
+  return world.tickCount;
+}
+
+void Rewind::Clear() {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock, [this] { return pending.empty() && !compressing; });
+  keyframes.clear();
+  keyframeBytes = 0;
+  journal.clear();
+  journalStart = 0;
+  liveTick = 0;
+}
+
+bool Rewind::IsReplaying(const World &world) const {
+  return world.tickCount < liveTick && world.tickCount >= journalStart;
+}
+
+const TickInput &Rewind::GetInput(uint64_t tick) const {
+  return journal[tick - journalStart];
+}
+
+uint64_t Rewind::GetOldestTick() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return keyframes.empty() ? journalStart : keyframes.front().tick;
+}
+
+size_t Rewind::GetMemoryBytes() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return keyframeBytes + journal.size() * sizeof(TickInput);
+}
+
+void Rewind::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    jobReady.wait(lock, [this] { return stopping || !pending.empty(); });
+    if (pending.empty()) {
+      return; // Stopping
+    }
+    Keyframe keyframe = std::move(pending.front());
+    pending.pop_front();
+    compressing = true;
+    lock.unlock();
+
+    int size = 0;
+    unsigned char *data =
+        CompressData(keyframe.data.data(), (int)keyframe.data.size(), &size);
+    keyframe.data.assign(data, data + (data ? size : 0));
+    MemFree(data);
+
+    lock.lock();
+    compressing = false;
+    if (!keyframe.data.empty()) {
+      keyframeBytes += keyframe.data.size();
+      keyframes.push_back(std::move(keyframe));
+    }
+
+    // Drop the oldest keyframes, and with them the journal they need, until
+    // both fit the budget. The newest keyframe is always kept.
+    while (keyframes.size() > 1) {
+      uint64_t span = keyframes.back().tick - keyframes.front().tick + interval;
+      if (keyframeBytes + span * sizeof(TickInput) <= budgetBytes) {
+        break;
+      }
+      keyframeBytes -= keyframes.front().data.size();
+      keyframes.pop_front();
+    }
+    if (pending.empty()) {
+      idle.notify_all();
+    }
+  }
+}
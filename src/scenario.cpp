@@ -0,0 +1,264 @@
+#include "scenario.h"
+#include "constants.h"
+#include "raylib.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace {
+// What values a parameter may take. Every value must also be finite and no
+// larger than LARGEST, so that no conversion to int overflows.
+enum Bound {
+  ANY,
+  NON_NEGATIVE,
+  POSITIVE, // Divisors, intervals, durations and rates
+  FRACTION, // 0..1
+  DISTANCE, // At least one world unit; the perception grid's cell size
+};
+const float LARGEST = 1e6f;
+
+// A Constants variable a scenario may set; exactly one pointer is non-null
+struct Parameter {
+  const char *name;
+  float *real;
+  int *integer;
+  Bound bound;
+};
+
+#define REAL(name, bound) {#name, &Constants::name, nullptr, bound}
+#define INTEGER(name) {#name, nullptr, &Constants::name, NON_NEGATIVE}
+const Parameter PARAMETERS[] = {
+    REAL(INITIAL_HEALTH, POSITIVE),
+    REAL(INITIAL_ENERGY, NON_NEGATIVE),
+    REAL(MIN_STRENGTH, NON_NEGATIVE),
+    REAL(MAX_STRENGTH, POSITIVE),
+    REAL(MIN_SPEED, NON_NEGATIVE),
+    REAL(MAX_SPEED, POSITIVE),
+    REAL(MIN_METABOLISM, NON_NEGATIVE),
+    REAL(MAX_METABOLISM, POSITIVE),
+    REAL(HUNGRY_THRESHOLD, ANY),
+    REAL(CRITICAL_HEALTH, ANY),
+    REAL(LOW_HEALTH, ANY),
+    REAL(MATING_ENERGY, ANY),
+    REAL(MATING_AGE, NON_NEGATIVE),
+    REAL(EATING_DURATION, POSITIVE),
+    REAL(MATING_COOLDOWN, POSITIVE),
+    REAL(FIGHT_COOLDOWN, POSITIVE),
+    REAL(SICK_RECOVERY_TIME, POSITIVE),
+    REAL(SICK_RECOVERY_HEALTH, NON_NEGATIVE),
+    REAL(BASE_MOVEMENT_SPEED, NON_NEGATIVE),
+    REAL(MAX_VELOCITY, POSITIVE),
+    REAL(BOUNDARY_BOUNCE, ANY),
+    REAL(FOOD_SEEK_FORCE, NON_NEGATIVE),
+    REAL(ENERGY_CONSUMPTION_RATE, POSITIVE),
+    REAL(HEALTH_DECAY_RATE, POSITIVE),
+    REAL(FOOD_ENERGY_VALUE, NON_NEGATIVE),
+    REAL(FOOD_SPAWN_INTERVAL, POSITIVE),
+    INTEGER(FOOD_SPAWN_COUNT),
+    INTEGER(INITIAL_CREATURE_COUNT),
+    INTEGER(INITIAL_FOOD_COUNT),
+    REAL(INITIAL_CREATURE_SIZE, POSITIVE),
+    REAL(FOOD_GROW_SIZE, NON_NEGATIVE),
+    REAL(FIELD_CAPACITY, POSITIVE),
+    REAL(FIELD_REGROWTH_RATE, POSITIVE),
+    REAL(FIELD_SEED_RATE, POSITIVE),
+    REAL(FIELD_DIFFUSION, NON_NEGATIVE),
+    REAL(FIELD_UPDATE_INTERVAL, POSITIVE),
+    REAL(FIELD_BITE_RATE, POSITIVE),
+    REAL(FIELD_SCENT_RADIUS, POSITIVE),
+    REAL(FIELD_FOOD_THRESHOLD, NON_NEGATIVE),
+    REAL(PERCEPTION_RANGE, DISTANCE),
+    REAL(PERCEPTION_FOV, NON_NEGATIVE),
+    REAL(TOUCH_RADIUS_SCALE, NON_NEGATIVE),
+    REAL(BRAIN_STEER_FORCE, NON_NEGATIVE),
+    REAL(BRAIN_AGE_SCALE, POSITIVE),
+    REAL(BRAIN_MUTATION_RATE, FRACTION),
+    REAL(BRAIN_MUTATION_SCALE, NON_NEGATIVE),
+};
+#undef REAL
+#undef INTEGER
+const size_t PARAMETER_COUNT = sizeof(PARAMETERS) / sizeof(PARAMETERS[0]);
+
+// Ranges a scenario may move but not turn inside out. As their ends can be
+// set in either order, they are checked once the whole file is in.
+const char *const ORDERED[][2] = {
+    {"MIN_STRENGTH", "MAX_STRENGTH"},
+    {"MIN_SPEED", "MAX_SPEED"},
+    {"MIN_METABOLISM", "MAX_METABOLISM"},
+};
+
+const Parameter *Find(const char *name) {
+  for (const Parameter &parameter : PARAMETERS) {
+    if (strcasecmp(name, parameter.name) == 0) {
+      return &parameter;
+    }
+  }
+  return nullptr;
+}
+
+// Why number cannot be the value of parameter, or nullptr if it can
+const char *Reject(const Parameter &parameter, double number) {
+  if (!std::isfinite(number) || std::fabs(number) > LARGEST) {
+    return "out of range";
+  }
+  switch (parameter.bound) {
+  case NON_NEGATIVE:
+    return number < 0 ? "must not be negative" : nullptr;
+  case POSITIVE:
+    return number <= 0 ? "must be positive" : nullptr;
+  case FRACTION:
+    return number < 0 || number > 1 ? "must be between 0 and 1" : nullptr;
+  case DISTANCE:
+    return number < 1 ? "must be at least 1" : nullptr;
+  default:
+    return nullptr;
+  }
+}
+
+// Strips leading and trailing whitespace in place
+char *Trim(char *text) {
+  while (isspace((unsigned char)*text)) {
+    text++;
+  }
+  char *end = text + strlen(text);
+  while (end > text && isspace((unsigned char)end[-1])) {
+    *--end = '\0';
+  }
+  return text;
+}
+
+bool ParseSwitch(const char *value, bool &out) {
+  if (strcmp(value, "on") == 0) {
+    out = true;
+  } else if (strcmp(value, "off") == 0) {
+    out = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Whether name is the toggle or parameter, and value valid for it. A value
+// of the right form that is out of bounds sets problem to why.
+bool Apply(const char *name, const char *value, ScenarioFeatures &features,
+           const char *&problem) {
+  if (strcmp(name, "contagion") == 0) {
+    return ParseSwitch(value, features.contagion);
+  }
+  if (strcmp(name, "fighting") == 0) {
+    return ParseSwitch(value, features.fighting);
+  }
+  if (strcmp(name, "food") == 0) {
+    if (strcmp(value, "items") != 0 && strcmp(value, "field") != 0) {
+      return false;
+    }
+    features.foodField = strcmp(value, "field") == 0;
+    return true;
+  }
+  if (strcmp(name, "creature_layout") == 0) {
+    return WorldGen::ParseLayout(value, features.creatureLayout);
+  }
+  if (strcmp(name, "food_layout") == 0) {
+    return WorldGen::ParseLayout(value, features.foodLayout);
+  }
+
+  const Parameter *parameter = Find(name);
+  if (!parameter) {
+    return false;
+  }
+  char *end;
+  double number = parameter->real ? strtod(value, &end)
+                                  : (double)strtol(value, &end, 10);
+  if (*end != '\0' || end == value) {
+    return false;
+  }
+  problem = Reject(*parameter, number);
+  if (problem) {
+    return false;
+  }
+  if (parameter->real) {
+    *parameter->real = (float)number;
+  } else {
+    *parameter->integer = (int)number;
+  }
+  return true;
+}
+} // namespace
+
+bool Scenario::Load(const std::string &path, ScenarioFeatures &features) {
+  FILE *file = fopen(path.c_str(), "r");
+  if (!file) {
+    TraceLog(LOG_WARNING, "SCENARIO: Could not open %s", path.c_str());
+    return false;
+  }
+
+  // Where each parameter was last set, and its value before the file, so
+  // that a range turned inside out can be reported and put back
+  int setOn[PARAMETER_COUNT] = {};
+  float before[PARAMETER_COUNT] = {};
+  for (size_t i = 0; i < PARAMETER_COUNT; i++) {
+    if (PARAMETERS[i].real) {
+      before[i] = *PARAMETERS[i].real;
+    }
+  }
+
+  bool ok = true;
+  int applied = 0;
+  char buffer[256];
+  for (int line = 1; fgets(buffer, sizeof(buffer), file); line++) {
+    char *comment = strchr(buffer, '#');
+    if (comment) {
+      *comment = '\0';
+    }
+    char *text = Trim(buffer);
+    if (*text == '\0') {
+      continue;
+    }
+    char *equals = strchr(text, '=');
+    if (!equals) {
+      TraceLog(LOG_WARNING, "SCENARIO: %s:%d: Expected name = value",
+               path.c_str(), line);
+      ok = false;
+      continue;
+    }
+    *equals = '\0';
+    const char *name = Trim(text);
+    const char *value = Trim(equals + 1);
+    const char *problem = nullptr;
+    if (Apply(name, value, features, problem)) {
+      applied++;
+      if (const Parameter *parameter = Find(name)) {
+        setOn[parameter - PARAMETERS] = line;
+      }
+    } else {
+      TraceLog(LOG_WARNING, "SCENARIO: %s:%d: Ignored %s = %s%s%s",
+               path.c_str(), line, name, value, problem ? ": " : "",
+               problem ? problem : "");
+      ok = false;
+    }
+  }
+  fclose(file);
+
+  for (const auto &range : ORDERED) {
+    const size_t low = Find(range[0]) - PARAMETERS;
+    const size_t high = Find(range[1]) - PARAMETERS;
+    if (*PARAMETERS[low].real <= *PARAMETERS[high].real) {
+      continue;
+    }
+    TraceLog(LOG_WARNING,
+             "SCENARIO: %s:%d: Ignored %s = %g and %s = %g: the minimum is "
+             "above the maximum",
+             path.c_str(), std::max(setOn[low], setOn[high]), range[0],
+             *PARAMETERS[low].real, range[1], *PARAMETERS[high].real);
+    applied -= (setOn[low] > 0) + (setOn[high] > 0);
+    *PARAMETERS[low].real = before[low];
+    *PARAMETERS[high].real = before[high];
+    ok = false;
+  }
+  TraceLog(LOG_INFO, "SCENARIO: %d settings from %s", applied, path.c_str());
+  return ok;
+}
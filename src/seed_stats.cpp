@@ -0,0 +1,138 @@
+#include "seed_stats.h"
+#include "constants.h"
+#include "world.h"
+#include <cmath>
+#include <cstdio>
+
+const int SeedStats::MEASURES;
+
+const char *SeedStats::GetName(int measure) {
+  return measure == 0 ? "Population"
+                      : TraitStats::GetName((Trait)(measure - 1));
+}
+
+void SeedStats::Run() {
+  runs.clear();
+  const float deltaTime = Constants::PHYSICS_TIMESTEP;
+  for (int s = 0; s < config.seeds; s++) {
+    Means means = {config.firstSeed + (unsigned)s, {}};
+    SetRandomSeed(means.seed);
+    World world;
+    world.seed = means.seed;
+    world.brainsEnabled = config.brains;
+    world.contagionEnabled = config.contagion;
+    world.fightingEnabled = config.fighting;
+    if (config.foodField) {
+      world.foodField.Reset((float)GetScreenWidth(), (float)GetScreenHeight());
+    }
+    for (int i = 0; i < config.creatureCount; i++) {
+      world.SpawnCreature({(float)GetRandomValue(0, GetScreenWidth()),
+                           (float)GetRandomValue(0, GetScreenHeight())},
+                          Constants::INITIAL_CREATURE_SIZE);
+    }
+
+    // Trait means are taken over the ticks with anyone alive; after an
+    // extinction the population counts as zero
+    uint64_t living = 0;
+    for (uint64_t tick = 0; tick < config.ticks; tick++) {
+      // Food arrives as in the interactive run
+      if (!world.foodField.IsEnabled()) {
+        world.foodSpawnTimer += deltaTime;
+      }
+      if (world.foodSpawnTimer >= Constants::FOOD_SPAWN_INTERVAL) {
+        for (int i = 0; i < Constants::FOOD_SPAWN_COUNT; i++) {
+          world.foods.emplace_back(
+              Vector2{(float)GetRandomValue(0, GetScreenWidth()),
+                      (float)GetRandomValue(0, GetScreenHeight())});
+        }
+        world.foodSpawnTimer = 0;
+      }
+      world.Step(deltaTime);
+      if (world.creatures.empty()) {
+        break;
+      }
+      means.values[0] += (double)world.creatures.size();
+      for (int t = 0; t < (int)Trait::COUNT; t++) {
+        means.values[1 + t] += world.traitStats.Get((Trait)t).GetMean();
+      }
+      living++;
+    }
+    means.values[0] /= (double)config.ticks;
+    for (int t = 0; t < (int)Trait::COUNT; t++) {
+      means.values[1 + t] /= living > 0 ? (double)living : 1.0;
+    }
+    runs.push_back(means);
+  }
+}
+
+bool SeedStats::Save(const std::string &path) const {
+  // One line per seed: the seed, then every measure
+  FILE *file = fopen(path.c_str(), "w");
+  if (!file) {
+    TraceLog(LOG_WARNING, "STATS: Could not write %s", path.c_str());
+    return false;
+  }
+  for (const Means &means : runs) {
+    fprintf(file, "%u", means.seed);
+    for (int m = 0; m < MEASURES; m++) {
+      fprintf(file, " %.9g", means.values[m]);
+    }
+    fprintf(file, "\n");
+  }
+  return fclose(file) == 0;
+}
+
+bool SeedStats::Compare(const std::string &path) {
+  report.clear();
+  FILE *file = fopen(path.c_str(), "r");
+  if (!file) {
+    report = TextFormat("Could not read %s", path.c_str());
+    return false;
+  }
+  std::vector<Means> saved;
+  Means means;
+  while (fscanf(file, "%u", &means.seed) == 1) {
+    for (int m = 0; m < MEASURES; m++) {
+      if (fscanf(file, "%lf", &means.values[m]) != 1) {
+        fclose(file);
+        report = TextFormat("%s is cut short", path.c_str());
+        return false;
+      }
+    }
+    saved.push_back(means);
+  }
+  fclose(file);
+  if (saved.size() < 2 || runs.size() < 2) {
+    report = "Need at least two seeds on each side";
+    return false;
+  }
+
+  // Average and squared standard error over the seeds of one build
+  auto summarize = [](const std::vector<Means> &all, int measure,
+                      double &mean, double &variance) {
+    double n = (double)all.size();
+    mean = 0.0;
+    for (const Means &m : all) {
+      mean += m.values[measure] / n;
+    }
+    double squares = 0.0;
+    for (const Means &m : all) {
+      squares += (m.values[measure] - mean) * (m.values[measure] - mean);
+    }
+    variance = squares / (n - 1) / n;
+  };
+
+  bool agree = true;
+  for (int m = 0; m < MEASURES; m++) {
+    double savedMean, savedVariance, mean, variance;
+    summarize(saved, m, savedMean, savedVariance);
+    summarize(runs, m, mean, variance);
+    double allowed = config.allowance * std::sqrt(savedVariance + variance);
+    bool close = std::fabs(mean - savedMean) <= allowed;
+    agree = agree && close;
+    report += TextFormat("%s%s %.4g/%.4g, allowed %.4g%s",
+                         report.empty() ? "" : "\n", GetName(m), savedMean,
+                         mean, allowed, close ? "" : " (differs)");
+  }
+  return agree;
+}
@@ -0,0 +1,155 @@
+#include "shared_export.h"
+#include "world.h"
+#include <algorithm>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace SharedLayout;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "the sequence number must be lock-free to live in shared memory");
+static_assert(sizeof(SharedHeader) == 168,
+              "SharedHeader layout is part of the documented format");
+
+// Sizes of one entry in each column, in CreatureColumn and FoodColumn order
+static const size_t CREATURE_COLUMN_BYTES[CREATURE_COLUMN_COUNT] = {
+    4, 4, 4, 1, 4, 4, 4, 4, 4, 4, 4};
+static const size_t FOOD_COLUMN_BYTES[FOOD_COLUMN_COUNT] = {4, 4};
+
+// Columns start on cache-line boundaries
+static uint64_t AlignUp(uint64_t offset) { return (offset + 63) & ~63ull; }
+
+SharedExport::~SharedExport() { Close(); }
+
+bool SharedExport::Open(const std::string &shmName, uint32_t creatureCapacity,
+                        uint32_t foodCapacity, float worldWidth,
+                        float worldHeight) {
+  Close();
+
+  uint64_t creatureOffsets[CREATURE_COLUMN_COUNT];
+  uint64_t foodOffsets[FOOD_COLUMN_COUNT];
+  uint64_t offset = AlignUp(sizeof(SharedHeader));
+  for (int column = 0; column < CREATURE_COLUMN_COUNT; column++) {
+    creatureOffsets[column] = offset;
+    offset = AlignUp(offset + CREATURE_COLUMN_BYTES[column] * creatureCapacity);
+  }
+  for (int column = 0; column < FOOD_COLUMN_COUNT; column++) {
+    foodOffsets[column] = offset;
+    offset = AlignUp(offset + FOOD_COLUMN_BYTES[column] * foodCapacity);
+  }
+
+  int fd = shm_open(shmName.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  if (ftruncate(fd, (off_t)offset) != 0) {
+    close(fd);
+    shm_unlink(shmName.c_str());
+    return false;
+  }
+  void *mapped =
+      mmap(nullptr, (size_t)offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd); // The mapping keeps the object alive
+  if (mapped == MAP_FAILED) {
+    shm_unlink(shmName.c_str());
+    return false;
+  }
+
+  name = shmName;
+  region = mapped;
+  regionBytes = (size_t)offset;
+
+  // Sequence starts odd so that readers wait for the first publish
+  header = new (region) SharedHeader();
+  header->sequence.store(1, std::memory_order_relaxed);
+  header->version = VERSION;
+  header->worldWidth = worldWidth;
+  header->worldHeight = worldHeight;
+  header->creatureCapacity = creatureCapacity;
+  header->foodCapacity = foodCapacity;
+  std::copy(creatureOffsets, creatureOffsets + CREATURE_COLUMN_COUNT,
+            header->creatureOffsets);
+  std::copy(foodOffsets, foodOffsets + FOOD_COLUMN_COUNT, header->foodOffsets);
+  // Magic last, so a reader that sees it also sees a complete header
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = MAGIC;
+  return true;
+}
+
+void SharedExport::Close() {
+  if (!region) {
+    return;
+  }
+  munmap(region, regionBytes);
+  shm_unlink(name.c_str());
+  region = nullptr;
+  header = nullptr;
+  regionBytes = 0;
+}
+
+void SharedExport::Publish(const World &world) {
+  if (!header) {
+    return;
+  }
+
+  // Enter the write section: odd sequence, then the data
+  uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+  if (sequence % 2 == 0) {
+    header->sequence.store(sequence + 1, std::memory_order_relaxed);
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const uint64_t *offsets = header->creatureOffsets;
+  uint32_t *ids = Column<uint32_t>(offsets[ID]);
+  float *xs = Column<float>(offsets[X]);
+  float *ys = Column<float>(offsets[Y]);
+  uint8_t *states = Column<uint8_t>(offsets[STATE]);
+  float *healths = Column<float>(offsets[HEALTH]);
+  float *energies = Column<float>(offsets[ENERGY]);
+  float *ages = Column<float>(offsets[AGE]);
+  float *strengths = Column<float>(offsets[STRENGTH]);
+  float *speeds = Column<float>(offsets[SPEED]);
+  float *metabolisms = Column<float>(offsets[METABOLISM]);
+  float *sizes = Column<float>(offsets[SIZE]);
+
+  uint32_t creatureCount = (uint32_t)std::min(
+      world.creatures.size(), (size_t)header->creatureCapacity);
+  for (uint32_t i = 0; i < creatureCount; i++) {
+    const Creature &creature = world.creatures[i];
+    Vector2 position = creature.GetPosition();
+    ids[i] = creature.GetId();
+    xs[i] = position.x;
+    ys[i] = position.y;
+    states[i] = (uint8_t)creature.GetState();
+    healths[i] = creature.GetHealth();
+    energies[i] = creature.GetEnergy();
+    ages[i] = creature.GetAge();
+    strengths[i] = creature.GetStrength();
+    speeds[i] = creature.GetSpeed();
+    metabolisms[i] = creature.GetMetabolism();
+    sizes[i] = creature.GetTraits().values[(int)Trait::SIZE];
+  }
+
+  float *foodXs = Column<float>(header->foodOffsets[FOOD_X]);
+  float *foodYs = Column<float>(header->foodOffsets[FOOD_Y]);
+  uint32_t foodCount =
+      (uint32_t)std::min(world.foods.size(), (size_t)header->foodCapacity);
+  for (uint32_t i = 0; i < foodCount; i++) {
+    Vector2 position = world.foods[i].GetPosition();
+    foodXs[i] = position.x;
+    foodYs[i] = position.y;
+  }
+
+  header->tick = world.tickCount;
+  header->simulationTime = world.simulationTime;
+  header->creatureCount = creatureCount;
+  header->creatureTotal = (uint32_t)world.creatures.size();
+  header->foodCount = foodCount;
+  header->foodTotal = (uint32_t)world.foods.size();
+
+  // Leave the write section: the even sequence publishes everything above
+  uint64_t odd = header->sequence.load(std::memory_order_relaxed);
+  header->sequence.store(odd + 1, std::memory_order_release);
+}
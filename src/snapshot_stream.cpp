@@ -0,0 +1,322 @@
+#include "snapshot_stream.h"
+#include "wire.h"
+#include "world.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0; // SO_NOSIGPIPE is set per socket instead
+#endif
+
+const int SnapshotServer::KEYFRAME_INTERVAL;
+const size_t SnapshotServer::MAX_CLIENT_BACKLOG;
+
+using Wire::Get;
+using Wire::Put;
+
+static uint8_t QuantizeUnit(float value, float range) {
+  return (uint8_t)(std::min(std::max(value / range, 0.0f), 1.0f) * 255.0f +
+                   0.5f);
+}
+
+static uint16_t QuantizeWide(float value, float range) {
+  return (uint16_t)(std::min(std::max(value / range, 0.0f), 1.0f) * 65535.0f +
+                    0.5f);
+}
+
+static void SetNonBlocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+SnapshotServer::~SnapshotServer() { Close(); }
+
+bool SnapshotServer::Open(const std::string &socketPath, float width,
+                          float height) {
+  Close();
+
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  std::strcpy(address.sun_path, socketPath.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  unlink(socketPath.c_str()); // Stale socket from an earlier run
+  if (bind(fd, (sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(fd, 8) != 0) {
+    close(fd);
+    return false;
+  }
+  SetNonBlocking(fd);
+
+  listenFd = fd;
+  path = socketPath;
+  worldWidth = width;
+  worldHeight = height;
+  return true;
+}
+
+void SnapshotServer::Close() {
+  for (auto &client : clients) {
+    close(client.fd);
+  }
+  clients.clear();
+  tracked.clear();
+  if (listenFd >= 0) {
+    close(listenFd);
+    unlink(path.c_str());
+    listenFd = -1;
+  }
+}
+
+void SnapshotServer::AcceptClients() {
+  for (;;) {
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) {
+      return;
+    }
+    SetNonBlocking(fd);
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    clients.push_back(Client{fd, true, std::vector<uint8_t>(), 0});
+  }
+}
+
+void SnapshotServer::Publish(const World &world, uint64_t tick) {
+  if (listenFd < 0) {
+    return;
+  }
+  AcceptClients();
+  if (clients.empty()) {
+    // Nobody to diff against; the next viewer starts from a keyframe
+    tracked.clear();
+    return;
+  }
+
+  bool periodic = tick - lastKeyframeTick >= (uint64_t)KEYFRAME_INTERVAL;
+  bool wantKeyframe = periodic;
+  for (const auto &client : clients) {
+    wantKeyframe = wantKeyframe || client.needsKeyframe;
+  }
+  Encode(world, tick, wantKeyframe);
+  if (periodic) {
+    lastKeyframeTick = tick;
+  }
+
+  for (auto &client : clients) {
+    if (client.needsKeyframe || periodic) {
+      Send(client, keyframe);
+      client.needsKeyframe = false;
+    } else {
+      Send(client, delta);
+    }
+  }
+
+  // Drop viewers whose socket failed or who fell too far behind
+  clients.erase(std::remove_if(clients.begin(), clients.end(),
+                               [](const Client &client) {
+                                 return client.fd < 0;
+                               }),
+                clients.end());
+}
+
+void SnapshotServer::Encode(const World &world, uint64_t tick,
+                            bool wantKeyframe) {
+  using namespace Snapshot;
+  generation++;
+
+  delta.resize(sizeof(FrameHeader));
+  if (wantKeyframe) {
+    keyframe.resize(sizeof(FrameHeader));
+  }
+  uint32_t deltaRecords = 0;
+
+  for (const auto &creature : world.creatures) {
+    CreatureRecord record;
+    record.x = QuantizeWide(creature.GetPosition().x, worldWidth);
+    record.y = QuantizeWide(creature.GetPosition().y, worldHeight);
+    record.state = (uint8_t)creature.GetState();
+    record.health = QuantizeUnit(creature.GetHealth(), 100.0f);
+    record.energy = QuantizeUnit(creature.GetEnergy(), 100.0f);
+
+    uint32_t id = creature.GetId();
+    uint8_t mask = ALL_FIELDS;
+    auto found = tracked.find(id);
+    if (found != tracked.end()) {
+      const CreatureRecord &last = found->second.record;
+      mask = 0;
+      if (last.x != record.x || last.y != record.y)
+        mask |= POSITION;
+      if (last.state != record.state)
+        mask |= STATE;
+      if (last.health != record.health)
+        mask |= HEALTH;
+      if (last.energy != record.energy)
+        mask |= ENERGY;
+      found->second = Tracked{record, generation};
+    } else {
+      tracked[id] = Tracked{record, generation};
+    }
+
+    if (mask != 0) {
+      Put(delta, id);
+      Put(delta, mask);
+      if (mask & POSITION) {
+        Put(delta, record.x);
+        Put(delta, record.y);
+      }
+      if (mask & STATE)
+        Put(delta, record.state);
+      if (mask & HEALTH)
+        Put(delta, record.health);
+      if (mask & ENERGY)
+        Put(delta, record.energy);
+      deltaRecords++;
+    }
+
+    if (wantKeyframe) {
+      Put(keyframe, id);
+      Put(keyframe, record.x);
+      Put(keyframe, record.y);
+      Put(keyframe, record.state);
+      Put(keyframe, record.health);
+      Put(keyframe, record.energy);
+    }
+  }
+
+  // Anything not seen this generation has died
+  removed.clear();
+  for (auto it = tracked.begin(); it != tracked.end();) {
+    if (it->second.seen != generation) {
+      removed.push_back(it->first);
+      it = tracked.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (uint32_t id : removed) {
+    Put(delta, id);
+  }
+
+  FrameHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = MAGIC;
+  header.tick = tick;
+  header.worldWidth = worldWidth;
+  header.worldHeight = worldHeight;
+
+  header.type = DELTA;
+  header.recordCount = deltaRecords;
+  header.removedCount = (uint32_t)removed.size();
+  header.payloadBytes = (uint32_t)(delta.size() - sizeof(FrameHeader));
+  std::memcpy(delta.data(), &header, sizeof(header));
+  lastDeltaBytes = delta.size();
+
+  if (wantKeyframe) {
+    header.type = KEYFRAME;
+    header.recordCount = (uint32_t)world.creatures.size();
+    header.removedCount = 0;
+    header.payloadBytes = (uint32_t)(keyframe.size() - sizeof(FrameHeader));
+    std::memcpy(keyframe.data(), &header, sizeof(header));
+  }
+}
+
+void SnapshotServer::Send(Client &client, const std::vector<uint8_t> &frame) {
+  // Drop what the socket has already taken once it is most of the buffer
+  if (client.sent > 0 && client.sent * 2 >= client.pending.size()) {
+    client.pending.erase(client.pending.begin(),
+                         client.pending.begin() + client.sent);
+    client.sent = 0;
+  }
+  if (client.pending.size() - client.sent + frame.size() >
+      MAX_CLIENT_BACKLOG) {
+    close(client.fd);
+    client.fd = -1;
+    return;
+  }
+  client.pending.insert(client.pending.end(), frame.begin(), frame.end());
+  if (!Flush(client)) {
+    close(client.fd);
+    client.fd = -1;
+  }
+}
+
+bool SnapshotServer::Flush(Client &client) {
+  while (client.sent < client.pending.size()) {
+    ssize_t written = send(client.fd, &client.pending[client.sent],
+                           client.pending.size() - client.sent, SEND_FLAGS);
+    if (written > 0) {
+      client.sent += (size_t)written;
+    } else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return true; // Try again next publish
+    } else if (written < 0 && errno == EINTR) {
+      continue;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t Snapshot::Decoder::Consume(const uint8_t *data, size_t size) {
+  size_t used = 0;
+  while (size - used >= sizeof(FrameHeader)) {
+    FrameHeader header;
+    std::memcpy(&header, data + used, sizeof(header));
+    if (header.magic != MAGIC) {
+      return used;
+    }
+    if (size - used < sizeof(header) + header.payloadBytes) {
+      return used; // Wait for the rest of the frame
+    }
+
+    const uint8_t *cursor = data + used + sizeof(header);
+    const uint8_t *end = cursor + header.payloadBytes;
+    if (header.type == KEYFRAME) {
+      creatures.clear();
+    }
+    for (uint32_t i = 0; i < header.recordCount; i++) {
+      uint32_t id = 0;
+      uint8_t mask = ALL_FIELDS;
+      Get(cursor, end, id);
+      if (header.type == DELTA) {
+        Get(cursor, end, mask);
+      }
+      CreatureRecord &record = creatures[id];
+      if (mask & POSITION) {
+        Get(cursor, end, record.x);
+        Get(cursor, end, record.y);
+      }
+      if (mask & STATE)
+        Get(cursor, end, record.state);
+      if (mask & HEALTH)
+        Get(cursor, end, record.health);
+      if (mask & ENERGY)
+        Get(cursor, end, record.energy);
+    }
+    for (uint32_t i = 0; i < header.removedCount; i++) {
+      uint32_t id = 0;
+      if (Get(cursor, end, id)) {
+        creatures.erase(id);
+      }
+    }
+
+    tick = header.tick;
+    used += sizeof(header) + header.payloadBytes;
+  }
+  return used;
+}
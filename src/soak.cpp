@@ -0,0 +1,187 @@
+#include "soak.h"
+#include "alloc_counter.h"
+#include "arena.h"
+#include "constants.h"
+#include "names.h"
+#include "world.h"
+#include <algorithm>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+namespace {
+uint64_t GetResidentBytes() {
+#if defined(__linux__)
+  FILE *file = fopen("/proc/self/statm", "r");
+  if (!file) {
+    return 0;
+  }
+  long pages, resident;
+  bool ok = fscanf(file, "%ld %ld", &pages, &resident) == 2;
+  fclose(file);
+  return ok ? (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE) : 0;
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info,
+                &count) != KERN_SUCCESS) {
+    return 0;
+  }
+  return info.resident_size;
+#else
+  return 0;
+#endif
+}
+
+// Least-squares line through one series against simulated hours
+struct Line {
+  double slope = 0.0; // Per hour
+  double intercept = 0.0;
+  double At(double hours) const { return intercept + slope * hours; }
+};
+
+template <typename Fn>
+Line Fit(const std::vector<SoakSample> &samples, size_t first, Fn value) {
+  double n = 0, sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+  for (size_t i = first; i < samples.size(); i++) {
+    double x = samples[i].simulationTime / 3600.0;
+    double y = value(samples[i]);
+    n++;
+    sumX += x;
+    sumY += y;
+    sumXX += x * x;
+    sumXY += x * y;
+  }
+  Line line;
+  double spread = n * sumXX - sumX * sumX;
+  if (n >= 2 && spread > 0) {
+    line.slope = (n * sumXY - sumX * sumY) / spread;
+  }
+  line.intercept = n > 0 ? (sumY - line.slope * sumX) / n : 0.0;
+  return line;
+}
+} // namespace
+
+void SoakMonitor::Record(const World &world, double seconds,
+                         const Arena &frameArena) {
+  tickMilliseconds.push_back((float)(seconds * 1e3));
+  double since = samples.empty() ? world.simulationTime
+                                 : world.simulationTime -
+                                       samples.back().simulationTime;
+  if (since >= Constants::SOAK_SAMPLE_INTERVAL) {
+    Sample(world, frameArena);
+  }
+}
+
+void SoakMonitor::Sample(const World &world, const Arena &frameArena) {
+  SoakSample sample;
+  sample.simulationTime = world.simulationTime;
+  sample.residentBytes = GetResidentBytes();
+  uint64_t allocations = AllocCounter::GetCount();
+  sample.allocations = allocations - allocationsAtSample;
+  allocationsAtSample = allocations;
+
+  // Percentiles of the ticks since the last sample; the buffer keeps its
+  // capacity for the next interval
+  size_t count = tickMilliseconds.size();
+  auto percentile = [&](double share) {
+    auto at = tickMilliseconds.begin() + (size_t)(share * (count - 1));
+    std::nth_element(tickMilliseconds.begin(), at, tickMilliseconds.end());
+    return *at;
+  };
+  sample.p50 = count > 0 ? percentile(0.5) : 0.0f;
+  sample.p99 = count > 0 ? percentile(0.99) : 0.0f;
+  tickMilliseconds.clear();
+
+  sample.population = (uint32_t)world.creatures.size();
+  sample.creatureCapacity = world.creatures.capacity();
+  sample.foodCapacity = world.foods.capacity();
+  sample.nameCount = Names::UsedCount();
+  sample.arenaBytes =
+      world.tickArena.GetCapacity() + frameArena.GetCapacity();
+  samples.push_back(sample);
+
+  TraceLog(LOG_INFO,
+           "SOAK: %.0fs: %u creatures, RSS %.1f MB, p50 %.3f ms, p99 %.3f ms, "
+           "%llu allocations, capacity %zu creatures %zu food, %zu names",
+           sample.simulationTime, sample.population,
+           sample.residentBytes / 1048576.0, sample.p50, sample.p99,
+           (unsigned long long)sample.allocations, sample.creatureCapacity,
+           sample.foodCapacity, sample.nameCount);
+}
+
+bool SoakMonitor::Report() const {
+  size_t first = 0;
+  while (first < samples.size() &&
+         samples[first].simulationTime < Constants::SOAK_WARMUP) {
+    first++;
+  }
+  if (samples.size() - first < 3) {
+    TraceLog(LOG_WARNING, "SOAK: Too short to fit; run past %.0fs of warm-up "
+                          "for at least 3 samples",
+             Constants::SOAK_WARMUP);
+    return true;
+  }
+  const double start = samples[first].simulationTime / 3600.0;
+  const double end = samples.back().simulationTime / 3600.0;
+  TraceLog(LOG_INFO, "SOAK: %d samples over %.2f h past warm-up, %d restarts",
+           (int)(samples.size() - first), end - start, restarts);
+
+  // Growth per simulated hour of everything sampled
+  Line rss = Fit(samples, first, [](const SoakSample &s) {
+    return s.residentBytes / 1048576.0;
+  });
+  Line allocations = Fit(samples, first, [](const SoakSample &s) {
+    return (double)s.allocations;
+  });
+  Line creatureCapacity = Fit(samples, first, [](const SoakSample &s) {
+    return (double)s.creatureCapacity;
+  });
+  Line foodCapacity = Fit(samples, first, [](const SoakSample &s) {
+    return (double)s.foodCapacity;
+  });
+  Line names = Fit(samples, first,
+                   [](const SoakSample &s) { return (double)s.nameCount; });
+  Line arenas = Fit(samples, first, [](const SoakSample &s) {
+    return s.arenaBytes / 1024.0;
+  });
+  TraceLog(LOG_INFO,
+           "SOAK: Per hour: RSS %+.2f MB, allocations per sample %+.1f, "
+           "capacity %+.1f creatures %+.1f food, %+.0f names, arenas %+.1f KB",
+           rss.slope, allocations.slope, creatureCapacity.slope,
+           foodCapacity.slope, names.slope, arenas.slope);
+
+  // Latency drift is the fitted rise over the run, as a share of the mean
+  Line p50 = Fit(samples, first, [](const SoakSample &s) { return s.p50; });
+  Line p99 = Fit(samples, first, [](const SoakSample &s) { return s.p99; });
+  auto drift = [&](const Line &line) {
+    double mean = line.At((start + end) / 2.0);
+    return mean > 0.0 ? line.slope * (end - start) / mean : 0.0;
+  };
+  TraceLog(LOG_INFO,
+           "SOAK: Tick latency: p50 %.3f to %.3f ms (%+.0f%%), p99 %.3f to "
+           "%.3f ms (%+.0f%%)",
+           p50.At(start), p50.At(end), drift(p50) * 100.0, p99.At(start),
+           p99.At(end), drift(p99) * 100.0);
+
+  bool passed = true;
+  if (samples.back().residentBytes == 0) {
+    TraceLog(LOG_WARNING, "SOAK: Resident memory unavailable, not checked");
+  } else if (rss.slope > Constants::SOAK_RSS_GROWTH_LIMIT) {
+    TraceLog(LOG_WARNING, "SOAK: RSS grows %.2f MB per hour, over %.2f",
+             rss.slope, Constants::SOAK_RSS_GROWTH_LIMIT);
+    passed = false;
+  }
+  if (drift(p99) > Constants::SOAK_LATENCY_DRIFT_LIMIT) {
+    TraceLog(LOG_WARNING, "SOAK: p99 tick latency drifted %+.0f%%, over %+.0f%%",
+             drift(p99) * 100.0, Constants::SOAK_LATENCY_DRIFT_LIMIT * 100.0);
+    passed = false;
+  }
+  TraceLog(passed ? LOG_INFO : LOG_WARNING, "SOAK: %s",
+           passed ? "Passed" : "Failed");
+  return passed;
+}
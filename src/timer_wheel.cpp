@@ -0,0 +1,97 @@
+#include "timer_wheel.h"
+
+const int TimerWheel::LEVELS;
+const int TimerWheel::SLOT_BITS;
+const int TimerWheel::SLOTS;
+const uint32_t TimerWheel::NONE;
+
+TimerWheel::TimerWheel() { Clear(); }
+
+void TimerWheel::Clear(uint64_t tick) {
+  nodes.clear();
+  freeNodes.clear();
+  for (int level = 0; level < LEVELS; level++) {
+    for (int slot = 0; slot < SLOTS; slot++) {
+      slots[level][slot] = NONE;
+    }
+  }
+  now = tick;
+  pending = 0;
+}
+
+void TimerWheel::Schedule(const TimerEvent &event, uint64_t delayTicks) {
+  // Longest delay the top level can represent
+  const uint64_t maxDelay = ((uint64_t)1 << (SLOT_BITS * LEVELS)) - 1;
+  if (delayTicks < 1)
+    delayTicks = 1;
+  if (delayTicks > maxDelay)
+    delayTicks = maxDelay;
+
+  uint32_t node;
+  if (!freeNodes.empty()) {
+    node = freeNodes.back();
+    freeNodes.pop_back();
+  } else {
+    node = (uint32_t)nodes.size();
+    nodes.push_back(Node());
+  }
+  nodes[node].expires = now + delayTicks;
+  nodes[node].event = event;
+  Insert(node);
+  pending++;
+}
+
+void TimerWheel::Insert(uint32_t node) {
+  uint64_t expires = nodes[node].expires;
+  uint64_t delta = expires - now;
+
+  // Lowest level whose span still covers the remaining delay
+  int level = 0;
+  while (level < LEVELS - 1 &&
+         delta >= ((uint64_t)1 << (SLOT_BITS * (level + 1)))) {
+    level++;
+  }
+  int slot = (int)((expires >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+  nodes[node].next = slots[level][slot];
+  slots[level][slot] = node;
+}
+
+void TimerWheel::Cascade(int level) {
+  int slot = (int)((now >> (SLOT_BITS * level)) & (SLOTS - 1));
+  uint32_t node = slots[level][slot];
+  slots[level][slot] = NONE;
+  while (node != NONE) {
+    uint32_t next = nodes[node].next;
+    Insert(node);
+    node = next;
+  }
+}
+
+void TimerWheel::Advance(uint64_t toTick, std::vector<TimerEvent> &fired) {
+  while (now < toTick) {
+    now++;
+
+    // Pull down every higher level whose lower turn just completed, outermost
+    // first so its timers can land in the levels cascaded after it
+    int rolled = 0;
+    while (rolled < LEVELS - 1 &&
+           (now & (((uint64_t)1 << (SLOT_BITS * (rolled + 1))) - 1)) == 0) {
+      rolled++;
+    }
+    for (int level = rolled; level > 0; level--) {
+      Cascade(level);
+    }
+
+    int slot = (int)(now & (SLOTS - 1));
+    uint32_t node = slots[0][slot];
+    slots[0][slot] = NONE;
+    while (node != NONE) {
+      uint32_t next = nodes[node].next;
+      fired.push_back(nodes[node].event);
+      freeNodes.push_back(node);
+      pending--;
+      node = next;
+    }
+  }
+}
@@ -0,0 +1,134 @@
+#include "trait_stats.h"
+#include <cmath>
+
+const int TraitHistogram::BINS;
+
+TraitHistogram::TraitHistogram(float min, float max) : min(min), max(max) {
+  Clear();
+}
+
+int TraitHistogram::BinOf(float value) const {
+  int bin = (int)((value - min) / (max - min) * BINS);
+  if (bin < 0)
+    return 0;
+  if (bin >= BINS)
+    return BINS - 1;
+  return bin;
+}
+
+void TraitHistogram::Add(float value) {
+  bins[BinOf(value)]++;
+  count++;
+  sum += value;
+  sumSquares += (double)value * value;
+}
+
+void TraitHistogram::Remove(float value) {
+  bins[BinOf(value)]--;
+  count--;
+  sum -= value;
+  sumSquares -= (double)value * value;
+}
+
+void TraitHistogram::Clear() {
+  for (int i = 0; i < BINS; i++) {
+    bins[i] = 0;
+  }
+  count = 0;
+  sum = 0.0;
+  sumSquares = 0.0;
+}
+
+float TraitHistogram::GetMean() const {
+  return count > 0 ? (float)(sum / count) : 0.0f;
+}
+
+float TraitHistogram::GetStdDev() const {
+  if (count < 2) {
+    return 0.0f;
+  }
+  double mean = sum / count;
+  double variance = sumSquares / count - mean * mean;
+  return variance > 0.0 ? (float)std::sqrt(variance) : 0.0f;
+}
+
+int TraitHistogram::GetPeakBin() const {
+  int peak = 0;
+  for (int i = 1; i < BINS; i++) {
+    if (bins[i] > bins[peak]) {
+      peak = i;
+    }
+  }
+  return peak;
+}
+
+float TraitHistogram::GetObservedMin() const {
+  for (int i = 0; i < BINS; i++) {
+    if (bins[i] > 0) {
+      return min + i * GetBinWidth();
+    }
+  }
+  return min;
+}
+
+float TraitHistogram::GetObservedMax() const {
+  for (int i = BINS - 1; i >= 0; i--) {
+    if (bins[i] > 0) {
+      return min + (i + 1) * GetBinWidth();
+    }
+  }
+  return max;
+}
+
+TraitStats::TraitStats() {
+  histograms[(int)Trait::STRENGTH] =
+      TraitHistogram(Constants::MIN_STRENGTH, Constants::MAX_STRENGTH);
+  histograms[(int)Trait::SPEED] =
+      TraitHistogram(Constants::MIN_SPEED, Constants::MAX_SPEED);
+  histograms[(int)Trait::METABOLISM] =
+      TraitHistogram(Constants::MIN_METABOLISM, Constants::MAX_METABOLISM);
+  histograms[(int)Trait::SIZE] = TraitHistogram(
+      Constants::INITIAL_CREATURE_SIZE, Constants::MAX_TRACKED_SIZE);
+}
+
+void TraitStats::Add(const TraitSample &sample) {
+  for (int i = 0; i < (int)Trait::COUNT; i++) {
+    histograms[i].Add(sample.values[i]);
+  }
+}
+
+void TraitStats::Remove(const TraitSample &sample) {
+  for (int i = 0; i < (int)Trait::COUNT; i++) {
+    histograms[i].Remove(sample.values[i]);
+  }
+}
+
+void TraitStats::Replace(const TraitSample &before, const TraitSample &after) {
+  for (int i = 0; i < (int)Trait::COUNT; i++) {
+    if (before.values[i] != after.values[i]) {
+      histograms[i].Remove(before.values[i]);
+      histograms[i].Add(after.values[i]);
+    }
+  }
+}
+
+void TraitStats::Clear() {
+  for (int i = 0; i < (int)Trait::COUNT; i++) {
+    histograms[i].Clear();
+  }
+}
+
+const char *TraitStats::GetName(Trait trait) {
+  switch (trait) {
+  case Trait::STRENGTH:
+    return "Strength";
+  case Trait::SPEED:
+    return "Speed";
+  case Trait::METABOLISM:
+    return "Metabolism";
+  case Trait::SIZE:
+    return "Size";
+  default:
+    return "Unknown";
+  }
+}
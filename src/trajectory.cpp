@@ -0,0 +1,288 @@
+#include "trajectory.h"
+#include "wire.h"
+#include "world.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace TrajectoryFormat;
+using Wire::GetSignedVarint;
+using Wire::GetVarint;
+using Wire::PutSignedVarint;
+using Wire::PutVarint;
+
+static int32_t Quantize(float value) {
+  return (int32_t)std::lround(value * POSITION_SCALE);
+}
+
+TrajectoryWriter::~TrajectoryWriter() { Close(); }
+
+bool TrajectoryWriter::Open(const std::string &path) {
+  Close();
+  file = fopen(path.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  offset = 0;
+  previousIndex = NO_INDEX;
+  tracks.clear();
+  FileHeader header = {MAGIC, VERSION, POSITION_SCALE, CHUNK_TICKS};
+  Write(&header, sizeof(header));
+  return true;
+}
+
+void TrajectoryWriter::Close() {
+  if (!file) {
+    return;
+  }
+  FlushChunk();
+  fclose(file);
+  file = nullptr;
+}
+
+void TrajectoryWriter::Write(const void *data, size_t size) {
+  fwrite(data, 1, size, file);
+  offset += size;
+}
+
+void TrajectoryWriter::Record(const World &world) {
+  if (!file) {
+    return;
+  }
+  uint64_t tick = world.tickCount;
+  if (!tracks.empty() &&
+      (tick <= lastTick || tick - chunkFirstTick >= CHUNK_TICKS)) {
+    FlushChunk();
+  }
+  if (tracks.empty()) {
+    chunkFirstTick = tick;
+  }
+  lastTick = tick;
+
+  for (const Creature &creature : world.creatures) {
+    if (creature.IsGhost()) {
+      continue;
+    }
+    int32_t x = Quantize(creature.GetPosition().x);
+    int32_t y = Quantize(creature.GetPosition().y);
+    CreatureState state = creature.GetState();
+
+    auto inserted = tracks.emplace(creature.GetId(), Track());
+    Track &track = inserted.first->second;
+    if (inserted.second) {
+      track.firstTick = tick;
+      PutSignedVarint(track.positions, x);
+      PutSignedVarint(track.positions, y);
+      track.states.emplace_back(1, state);
+    } else {
+      if (tick - track.lastTick > 1) {
+        track.gaps.emplace_back(track.count, tick - track.lastTick - 1);
+      }
+      PutSignedVarint(track.positions, (int64_t)x - track.x);
+      PutSignedVarint(track.positions, (int64_t)y - track.y);
+      if (track.states.back().second == state) {
+        track.states.back().first++;
+      } else {
+        track.states.emplace_back(1, state);
+      }
+    }
+    track.x = x;
+    track.y = y;
+    track.lastTick = tick;
+    track.count++;
+  }
+}
+
+void TrajectoryWriter::FlushChunk() {
+  if (tracks.empty()) {
+    return;
+  }
+  std::vector<IndexEntry> entries;
+  entries.reserve(tracks.size());
+  for (const auto &pair : tracks) {
+    entries.push_back({pair.first, 0, 0});
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const IndexEntry &a, const IndexEntry &b) { return a.id < b.id; });
+
+  for (IndexEntry &entry : entries) {
+    const Track &track = tracks[entry.id];
+    buffer.clear();
+    PutVarint(buffer, track.firstTick - chunkFirstTick);
+    PutVarint(buffer, track.count);
+    buffer.insert(buffer.end(), track.positions.begin(), track.positions.end());
+    PutVarint(buffer, track.states.size());
+    for (const auto &run : track.states) {
+      PutVarint(buffer, run.first);
+      buffer.push_back((uint8_t)run.second);
+    }
+    PutVarint(buffer, track.gaps.size());
+    for (const auto &gap : track.gaps) {
+      PutVarint(buffer, gap.first);
+      PutVarint(buffer, gap.second);
+    }
+    entry.blockOffset = offset;
+    entry.blockBytes = (uint32_t)buffer.size();
+    Write(buffer.data(), buffer.size());
+  }
+
+  uint64_t indexOffset = offset;
+  ChunkIndex index = {INDEX_MAGIC, (uint32_t)entries.size(), chunkFirstTick,
+                      lastTick, previousIndex};
+  Write(&index, sizeof(index));
+  Write(entries.data(), entries.size() * sizeof(IndexEntry));
+  Trailer trailer = {indexOffset, INDEX_MAGIC, 0};
+  Write(&trailer, sizeof(trailer));
+  fflush(file);
+
+  previousIndex = indexOffset;
+  tracks.clear();
+}
+
+TrajectoryReader::~TrajectoryReader() {
+  if (file) {
+    fclose(file);
+  }
+}
+
+bool TrajectoryReader::Open(const std::string &path) {
+  if (file) {
+    fclose(file);
+  }
+  chunks.clear();
+  file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+
+  FileHeader header;
+  if (fread(&header, sizeof(header), 1, file) != 1 || header.magic != MAGIC ||
+      header.version != VERSION) {
+    return false;
+  }
+  positionScale = header.positionScale;
+
+  // A writer that was cut off mid-chunk leaves no trailer at the end, so
+  // only files that were closed cleanly are readable
+  Trailer trailer;
+  if (fseeko(file, -(off_t)sizeof(trailer), SEEK_END) != 0 ||
+      fread(&trailer, sizeof(trailer), 1, file) != 1) {
+    return true; // No chunks yet
+  }
+  if (trailer.magic != INDEX_MAGIC) {
+    return false;
+  }
+
+  uint64_t at = trailer.indexOffset;
+  while (at != NO_INDEX) {
+    ChunkIndex index;
+    if (fseeko(file, (off_t)at, SEEK_SET) != 0 ||
+        fread(&index, sizeof(index), 1, file) != 1 ||
+        index.magic != INDEX_MAGIC ||
+        (index.previousIndex != NO_INDEX && index.previousIndex >= at)) {
+      chunks.clear();
+      return false;
+    }
+    Chunk chunk;
+    chunk.firstTick = index.firstTick;
+    chunk.lastTick = index.lastTick;
+    chunk.entries.resize(index.entryCount);
+    if (index.entryCount > 0 &&
+        fread(chunk.entries.data(), sizeof(IndexEntry), index.entryCount,
+              file) != index.entryCount) {
+      chunks.clear();
+      return false;
+    }
+    chunks.push_back(std::move(chunk));
+    at = index.previousIndex;
+  }
+  std::reverse(chunks.begin(), chunks.end());
+  return true;
+}
+
+bool TrajectoryReader::Read(uint32_t id, uint64_t firstTick, uint64_t lastTick,
+                            std::vector<Sample> &out) {
+  if (!file) {
+    return false;
+  }
+  std::vector<uint8_t> block;
+  for (const Chunk &chunk : chunks) {
+    if (chunk.lastTick < firstTick || chunk.firstTick > lastTick) {
+      continue;
+    }
+    auto entry = std::lower_bound(
+        chunk.entries.begin(), chunk.entries.end(), id,
+        [](const IndexEntry &e, uint32_t id) { return e.id < id; });
+    if (entry == chunk.entries.end() || entry->id != id) {
+      continue;
+    }
+
+    block.resize(entry->blockBytes);
+    if (fseeko(file, (off_t)entry->blockOffset, SEEK_SET) != 0 ||
+        fread(block.data(), 1, block.size(), file) != block.size()) {
+      return false;
+    }
+    const uint8_t *cursor = block.data();
+    const uint8_t *end = cursor + block.size();
+
+    uint64_t tickOffset, count;
+    // Every sample takes at least two bytes, which bounds a damaged count
+    if (!GetVarint(cursor, end, tickOffset) || !GetVarint(cursor, end, count) ||
+        count > block.size() / 2) {
+      return false;
+    }
+    std::vector<Sample> samples((size_t)count);
+    int64_t x = 0, y = 0;
+    for (Sample &sample : samples) {
+      int64_t dx, dy;
+      if (!GetSignedVarint(cursor, end, dx) ||
+          !GetSignedVarint(cursor, end, dy)) {
+        return false;
+      }
+      x += dx;
+      y += dy;
+      sample.position = {x / positionScale, y / positionScale};
+    }
+
+    uint64_t runCount;
+    if (!GetVarint(cursor, end, runCount)) {
+      return false;
+    }
+    size_t next = 0;
+    for (uint64_t i = 0; i < runCount; i++) {
+      uint64_t length;
+      uint8_t state;
+      if (!GetVarint(cursor, end, length) || !Wire::Get(cursor, end, state) ||
+          length > samples.size() - next ||
+          state >= (uint8_t)CreatureState::COUNT) {
+        return false;
+      }
+      for (uint64_t j = 0; j < length; j++) {
+        samples[next++].state = (CreatureState)state;
+      }
+    }
+
+    uint64_t gapCount;
+    if (next != samples.size() || !GetVarint(cursor, end, gapCount)) {
+      return false;
+    }
+    std::vector<uint64_t> missed(samples.size(), 0);
+    for (uint64_t i = 0; i < gapCount; i++) {
+      uint64_t sample, ticks;
+      if (!GetVarint(cursor, end, sample) || !GetVarint(cursor, end, ticks) ||
+          sample >= samples.size()) {
+        return false;
+      }
+      missed[sample] = ticks;
+    }
+
+    uint64_t tick = chunk.firstTick + tickOffset;
+    for (size_t i = 0; i < samples.size(); i++) {
+      tick += missed[i] + (i > 0 ? 1 : 0);
+      samples[i].tick = tick;
+      if (tick >= firstTick && tick <= lastTick) {
+        out.push_back(samples[i]);
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,610 @@
+#include "world.h"
+#include "constants.h"
+#include "names.h"
+#include "wire.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+void World::Clear() {
+  creatures.clear();
+  foods.clear();
+  births.clear();
+  birthGenomes.clear();
+  birthParents.clear();
+  lineage.Clear();
+  traitStats.Clear();
+  timers.Clear();
+  brains.Clear();
+  creatureTimers.clear();
+  simulationTime = 0.0;
+  tickCount = 0;
+  foodSpawnTimer = 0.0f;
+  indexById.clear();
+  foodClaims.clear();
+  ghostInfections.clear();
+}
+
+void World::Save(std::vector<uint8_t> &out) const {
+  using Wire::Put;
+  Put(out, tickCount);
+  Put(out, seed);
+  Put(out, simulationTime);
+  Put(out, foodSpawnTimer);
+  Put(out, timers.GetTick());
+  Put(out, Creature::GetNextId());
+  const Names::Mark names = Names::GetMark();
+  Put(out, names.handedOut);
+  Put(out, names.engine);
+  Put(out, (uint32_t)creatures.size());
+  for (uint32_t i = 0; i < creatures.size(); i++) {
+    WriteCreature(i, out);
+  }
+  Put(out, (uint32_t)foods.size());
+  for (const auto &food : foods) {
+    Put(out, food.GetPosition());
+  }
+  foodField.Write(out);
+  lineage.Write(out);
+}
+
+bool World::Load(const uint8_t *data, size_t size) {
+  using Wire::Get;
+  const uint8_t *cursor = data;
+  const uint8_t *end = data + size;
+  uint64_t wheelTick;
+  uint32_t nextId;
+  Names::Mark names;
+  uint32_t count;
+  Clear();
+  if (!Get(cursor, end, tickCount) || !Get(cursor, end, seed) ||
+      !Get(cursor, end, simulationTime) ||
+      !Get(cursor, end, foodSpawnTimer) || !Get(cursor, end, wheelTick) ||
+      !Get(cursor, end, nextId) || !Get(cursor, end, names.handedOut) ||
+      !Get(cursor, end, names.engine) ||
+      !Get(cursor, end, count)) {
+    return false;
+  }
+  timers.Clear(wheelTick);
+  Creature::ReserveIds(nextId);
+  Names::Restore(names);
+
+  // Pending timers are rebuilt from each creature's due ticks
+  Creature creature = Creature::Blank();
+  CreatureTimers pending;
+  Genome genome;
+  for (uint32_t i = 0; i < count; i++) {
+    if (!ReadCreature(cursor, end, creature, pending, genome)) {
+      return false;
+    }
+    indexById[creature.GetId()] = (uint32_t)creatures.size();
+    traitStats.Add(creature.GetTraits());
+    if (brainsEnabled) {
+      brains.Add(genome);
+    }
+    creatures.push_back(creature);
+    creatureTimers.push_back(pending);
+    creatures.back().Rearm(*this);
+  }
+  if (!Get(cursor, end, count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    Vector2 position;
+    if (!Get(cursor, end, position)) {
+      return false;
+    }
+    foods.emplace_back(position);
+  }
+  return foodField.Read(cursor, end) && lineage.Read(cursor, end) &&
+         cursor == end;
+}
+
+void World::SpawnCreature(Vector2 pos, float size) {
+  creatures.emplace_back(pos, size);
+  indexById[creatures.back().GetId()] = (uint32_t)creatures.size() - 1;
+  lineage.AddFounder(creatures.back().GetId());
+  traitStats.Add(creatures.back().GetTraits());
+  creatureTimers.emplace_back();
+  if (brainsEnabled) {
+    brains.Add(Genome::Random());
+  }
+}
+
+void World::WriteCreature(uint32_t index, std::vector<uint8_t> &out) const {
+  creatures[index].Write(out);
+  Wire::Put(out, creatureTimers[index].tokens);
+  Wire::Put(out, creatureTimers[index].due);
+  if (brainsEnabled) {
+    Wire::Put(out, brains.GetGenome(index));
+  }
+}
+
+bool World::ReadCreature(const uint8_t *&cursor, const uint8_t *end,
+                         Creature &creature, CreatureTimers &timers,
+                         Genome &genome) const {
+  return Creature::Read(cursor, end, creature) &&
+         Wire::Get(cursor, end, timers.tokens) &&
+         Wire::Get(cursor, end, timers.due) &&
+         (!brainsEnabled || Wire::Get(cursor, end, genome));
+}
+
+Creature *World::Find(uint32_t id) {
+  auto it = indexById.find(id);
+  return it == indexById.end() ? nullptr : &creatures[it->second];
+}
+
+uint64_t World::ScheduleTimer(const TimerEvent &event, float seconds) {
+  uint64_t ticks =
+      (uint64_t)std::ceil(seconds / Constants::PHYSICS_TIMESTEP);
+  timers.Schedule(event, ticks);
+  return timers.GetTick() + std::max(ticks, (uint64_t)1);
+}
+
+void World::ScheduleTimerAt(const TimerEvent &event, uint64_t dueTick) {
+  // Anything already overdue fires on the next Step
+  uint64_t now = timers.GetTick();
+  timers.Schedule(event, dueTick > now ? dueTick - now : 1);
+}
+
+void World::AddGhost(const Creature &ghost, const Genome &genome) {
+  creatures.push_back(ghost);
+  creatures.back().MakeGhost();
+  indexById[ghost.GetId()] = (uint32_t)creatures.size() - 1;
+  creatureTimers.emplace_back(); // Its owner runs its timers
+  if (brainsEnabled) {
+    brains.Add(genome);
+  }
+}
+
+void World::AddGhostFood(Vector2 position) {
+  foods.emplace_back(position);
+  foods.back().MakeGhost();
+}
+
+void World::RemoveGhosts() {
+  for (size_t i = 0; i < creatures.size();) {
+    if (!creatures[i].IsGhost()) {
+      i++;
+      continue;
+    }
+    indexById.erase(creatures[i].GetId());
+    if (brainsEnabled) {
+      brains.Remove((uint32_t)i);
+    }
+    if (i + 1 < creatures.size()) {
+      creatures[i] = std::move(creatures.back());
+      creatureTimers[i] = creatureTimers.back();
+      indexById[creatures[i].GetId()] = (uint32_t)i;
+    }
+    creatures.pop_back();
+    creatureTimers.pop_back();
+  }
+  foods.erase(std::remove_if(foods.begin(), foods.end(),
+                             [](const Food &f) { return f.IsGhost(); }),
+              foods.end());
+}
+
+void World::Adopt(const Creature &creature, const CreatureTimers &timers,
+                  const Genome &genome, const Lineage::Placement &placement) {
+  lineage.AddMigrant(creature.GetId(), placement);
+  traitStats.Add(creature.GetTraits());
+  if (brainsEnabled) {
+    brains.Add(genome);
+  }
+  indexById[creature.GetId()] = (uint32_t)creatures.size();
+  creatures.push_back(creature);
+  creatureTimers.push_back(timers);
+  creatures.back().Rearm(*this);
+}
+
+Creature World::Release(uint32_t index) {
+  Creature creature = std::move(creatures[index]);
+  lineage.Depart(creature.GetId());
+  traitStats.Remove(creature.GetTraits());
+  indexById.erase(creature.GetId());
+  if (brainsEnabled) {
+    brains.Remove(index);
+  }
+  if (index + 1 < creatures.size()) {
+    creatures[index] = std::move(creatures.back());
+    creatureTimers[index] = creatureTimers.back();
+    indexById[creatures[index].GetId()] = index;
+  }
+  creatures.pop_back();
+  creatureTimers.pop_back();
+  return creature;
+}
+
+void World::BucketByState() {
+  // Counting sort: size every bucket, then scatter indices in storage order
+  const int states = (int)CreatureState::COUNT;
+  uint32_t counts[states] = {};
+  for (uint32_t i = 0; i < creatures.size(); i++) {
+    if (IsActive(i)) {
+      counts[(int)creatures[i].GetState()]++;
+    }
+  }
+  bucketStart[0] = 0;
+  for (int state = 0; state < states; state++) {
+    bucketStart[state + 1] = bucketStart[state] + counts[state];
+    counts[state] = bucketStart[state];
+  }
+  for (uint32_t i = 0; i < creatures.size(); i++) {
+    if (IsActive(i)) {
+      bucketIndices[counts[(int)creatures[i].GetState()]++] = i;
+    }
+  }
+}
+
+RandomStream World::RandomFor(uint32_t id, RandomPurpose purpose,
+                              uint32_t other) const {
+  uint64_t key = RandomStream::Mix(seed ^ tickCount * 0x9E3779B97F4A7C15ull);
+  key = RandomStream::Mix(key ^ ((uint64_t)id << 32 | other));
+  return RandomStream(key ^ (uint64_t)purpose << 56);
+}
+
+ActivityTier World::GetTier(const Creature &creature) const {
+  Vector2 position = creature.GetPosition();
+  if (creature.GetId() == focusId ||
+      CheckCollisionPointRec(position, focusRegion)) {
+    return ActivityTier::FOCUS;
+  }
+  const float margin = Constants::ACTIVITY_NEAR_MARGIN;
+  Rectangle near = {focusRegion.x - margin, focusRegion.y - margin,
+                    focusRegion.width + margin * 2,
+                    focusRegion.height + margin * 2};
+  return CheckCollisionPointRec(position, near) ? ActivityTier::NEAR
+                                                : ActivityTier::FAR;
+}
+
+// Interleaves the low 16 bits of x and y, x in the even bits
+static uint32_t MortonKey(uint32_t x, uint32_t y) {
+  auto spread = [](uint32_t v) {
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+  };
+  return spread(x) | (spread(y) << 1);
+}
+
+bool World::ReorderStorage() {
+  uint32_t count = (uint32_t)creatures.size();
+  if (count < 2) {
+    return false;
+  }
+
+  // Keys on a 65536 x 65536 grid over the population's bounds
+  Vector2 low = creatures[0].GetPosition();
+  Vector2 high = low;
+  for (const auto &creature : creatures) {
+    Vector2 position = creature.GetPosition();
+    low.x = std::min(low.x, position.x);
+    low.y = std::min(low.y, position.y);
+    high.x = std::max(high.x, position.x);
+    high.y = std::max(high.y, position.y);
+  }
+  float scaleX = 65535.0f / std::max(high.x - low.x, 1.0f);
+  float scaleY = 65535.0f / std::max(high.y - low.y, 1.0f);
+  uint32_t *keys = tickArena.AllocateArray<uint32_t>(count);
+  uint32_t descents = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    Vector2 position = creatures[i].GetPosition();
+    keys[i] = MortonKey((uint32_t)((position.x - low.x) * scaleX),
+                        (uint32_t)((position.y - low.y) * scaleY));
+    if (i > 0 && keys[i] < keys[i - 1]) {
+      descents++;
+    }
+  }
+  if (descents <= count * Constants::REORDER_DISORDER) {
+    return false;
+  }
+
+  // Ties break on id so the order never depends on the old one
+  uint32_t *order = tickArena.AllocateArray<uint32_t>(count);
+  for (uint32_t i = 0; i < count; i++) {
+    order[i] = i;
+  }
+  std::sort(order, order + count, [&](uint32_t a, uint32_t b) {
+    if (keys[a] != keys[b]) {
+      return keys[a] < keys[b];
+    }
+    return creatures[a].GetId() < creatures[b].GetId();
+  });
+
+  reordered.clear();
+  reordered.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    reordered.push_back(std::move(creatures[order[i]]));
+  }
+  creatures.swap(reordered);
+  reordered.clear();
+  CreatureTimers *timersInOrder =
+      tickArena.AllocateArray<CreatureTimers>(count);
+  for (uint32_t i = 0; i < count; i++) {
+    timersInOrder[i] = creatureTimers[order[i]];
+  }
+  std::copy(timersInOrder, timersInOrder + count, creatureTimers.begin());
+  for (uint32_t i = 0; i < count; i++) {
+    indexById[creatures[i].GetId()] = i;
+  }
+  if (brainsEnabled) {
+    brains.Reorder(order);
+  }
+  return true;
+}
+
+void World::Step(float deltaTime) {
+  typedef void (World::*Kernel)(float);
+  static const Kernel KERNELS[2][2][2] = {
+      {{&World::StepKernel<false, false, false>,
+        &World::StepKernel<false, false, true>},
+       {&World::StepKernel<false, true, false>,
+        &World::StepKernel<false, true, true>}},
+      {{&World::StepKernel<true, false, false>,
+        &World::StepKernel<true, false, true>},
+       {&World::StepKernel<true, true, false>,
+        &World::StepKernel<true, true, true>}},
+  };
+  (this->*KERNELS[contagionEnabled][fightingEnabled][foodField.IsEnabled()])(
+      deltaTime);
+}
+
+template <bool CONTAGION, bool FIGHTING, bool FIELD>
+void World::StepKernel(float deltaTime) {
+  typedef std::chrono::steady_clock Clock;
+  const bool counting = perfCounters && perfCounters->IsOpen();
+  uint64_t eventsStart[(int)PerfEvent::COUNT];
+  if (counting) {
+    perfCounters->Read(eventsStart);
+  }
+  Clock::time_point phaseStart = Clock::now();
+  auto endPhase = [&](TickPhase phase) {
+    Clock::time_point now = Clock::now();
+    phaseSeconds[(int)phase] =
+        std::chrono::duration<double>(now - phaseStart).count();
+    phaseStart = now;
+    if (counting) {
+      uint64_t events[(int)PerfEvent::COUNT];
+      perfCounters->Read(events);
+      for (int event = 0; event < (int)PerfEvent::COUNT; event++) {
+        // Rescaled totals can step back a little when counters are shared
+        phaseEvents[(int)phase][event] =
+            events[event] > eventsStart[event]
+                ? events[event] - eventsStart[event]
+                : 0;
+        eventsStart[event] = events[event];
+      }
+    }
+  };
+
+  FireTimers(deltaTime);
+  endPhase(TickPhase::TIMERS);
+
+  if (FIELD) {
+    foodField.Advance(deltaTime);
+  }
+  endPhase(TickPhase::FOOD_FIELD);
+
+  // The population does not change size until births and deaths are settled,
+  // so one bucket array serves every phase of this tick
+  bucketIndices = tickArena.AllocateArray<uint32_t>(creatures.size());
+  stepTimes = tickArena.AllocateArray<float>(creatures.size());
+  foodClaims.clear();
+  ghostInfections.clear();
+
+  // Pick who takes part in this Step. Off-screen creatures are staggered by
+  // id so each Step updates a similar share of them.
+  for (auto &count : tierCounts) {
+    count = 0;
+  }
+  for (uint32_t i = 0; i < creatures.size(); i++) {
+    Creature &creature = creatures[i];
+    if (creature.IsGhost()) {
+      stepTimes[i] = -1.0f; // Its owner updates it
+      continue;
+    }
+    ActivityTier tier = multiRate ? GetTier(creature) : ActivityTier::FOCUS;
+    uint32_t period = tier == ActivityTier::FOCUS ? 1
+                      : tier == ActivityTier::NEAR
+                          ? Constants::ACTIVITY_NEAR_PERIOD
+                          : Constants::ACTIVITY_FAR_PERIOD;
+    tierCounts[(int)tier]++;
+    if ((tickCount + creature.GetId()) % period == 0) {
+      stepTimes[i] = creature.Resume(deltaTime);
+    } else {
+      creature.Defer(deltaTime);
+      stepTimes[i] = -1.0f;
+    }
+  }
+
+  // Each phase of Creature::Update runs as one loop over the creatures it
+  // applies to, rather than every creature branching through all of them.
+  // Children are buffered in births so creatures never reallocates mid-tick.
+  for (uint32_t i = 0; i < creatures.size(); i++) {
+    if (IsActive(i)) {
+      creatures[i].UpdateVitals(stepTimes[i]);
+    }
+  }
+  BucketByState();
+  endPhase(TickPhase::VITALS);
+
+  // Nothing moves again until the movement phase, so one batched pass serves
+  // every phase that reacts to surroundings
+  perception.Update<FIELD>(*this);
+  endPhase(TickPhase::PERCEPTION);
+
+  // Every brain is evaluated in one batch
+  if (brainsEnabled) {
+    thoughts = tickArena.AllocateArray<BrainOutput>(creatures.size());
+    for (uint32_t i = 0; i < creatures.size(); i++) {
+      if (IsActive(i)) {
+        brains.SetInput(i, creatures[i].Sense(perception.Get(i)));
+      }
+    }
+    brains.Evaluate();
+    for (uint32_t i = 0; i < creatures.size(); i++) {
+      if (IsActive(i)) {
+        thoughts[i] = brains.GetOutput(i);
+      }
+    }
+  }
+  endPhase(TickPhase::THINKING);
+
+  auto feed = [&](uint32_t i) {
+    creatures[i].UpdateFeeding<FIELD>(*this, perception.Get(i), stepTimes[i]);
+  };
+  ForEachIndexInState(CreatureState::HUNTING, feed);
+  ForEachIndexInState(CreatureState::EATING, feed);
+  if (claimExchange) {
+    claimExchange->SettleFood(*this);
+  }
+  BucketByState();
+  endPhase(TickPhase::FEEDING);
+
+  // Eating creatures simply wait for their EATING_DONE timer. Fights and
+  // matings are only proposed here, and timers only queued, so no creature
+  // touches another or the timer wheel.
+  interactions.Begin((uint32_t)creatures.size(), tickArena);
+  for (int state = 0; state < (int)CreatureState::COUNT; state++) {
+    if ((CreatureState)state != CreatureState::EATING) {
+      ForEachIndexInState((CreatureState)state, [&](uint32_t i) {
+        bool fellSick = false;
+        interactions.SetCount(i, creatures[i].UpdateState<FIGHTING, FIELD>(
+                                     *this, perception.Get(i),
+                                     interactions.GetSlots(i), fellSick));
+        if (fellSick) {
+          interactions.QueueRecovery(i);
+        }
+      });
+    }
+  }
+  endPhase(TickPhase::DECISION);
+
+  interactions.Match(*this);
+  if (claimExchange) {
+    claimExchange->SettleClaims(*this);
+  }
+  interactions.Apply(*this);
+  BucketByState();
+  endPhase(TickPhase::INTERACTION);
+
+  if (CONTAGION) {
+    ForEachIndexInState(CreatureState::SICK, [&](uint32_t i) {
+      creatures[i].SpreadSickness(
+          *this,
+          perception.Near(*this, i, creatures[i].GetContagionRadius()));
+    });
+    BucketByState();
+  }
+  if (claimExchange) {
+    claimExchange->SettleOutcomes(*this);
+    BucketByState();
+  }
+  endPhase(TickPhase::CONTAGION);
+
+  auto halt = [](Creature &creature) { creature.Halt(); };
+  auto wander = [&](Creature &creature) {
+    creature.Wander(RandomFor(creature.GetId(), RandomPurpose::WANDER),
+                    *this);
+  };
+  auto move = [&](uint32_t i) { creatures[i].Move(stepTimes[i]); };
+  ForEachInState(CreatureState::EATING, halt);
+  ForEachInState(CreatureState::FIGHTING, halt);
+  ForEachInState(CreatureState::MATING, halt);
+  ForEachInState(CreatureState::WANDERING, wander);
+  ForEachInState(CreatureState::SICK, wander);
+  ForEachIndexInState(CreatureState::WANDERING, move);
+  ForEachIndexInState(CreatureState::SICK, move);
+  ForEachIndexInState(CreatureState::HUNTING, move);
+  for (uint32_t i = 0; i < creatures.size(); i++) {
+    if (IsActive(i)) {
+      creatures[i].UpdateColor();
+    }
+  }
+  endPhase(TickPhase::MOVEMENT);
+
+  SettleBirthsAndDeaths();
+  endPhase(TickPhase::BIRTHS_AND_DEATHS);
+
+  // Creatures born since the last sort sit at the end and everyone drifts,
+  // so storage order is checked now and then and restored when it has
+  // decayed
+  if (tickCount % Constants::REORDER_CHECK_INTERVAL == 0) {
+    ReorderStorage();
+  }
+  bucketIndices = nullptr;
+  stepTimes = nullptr;
+  thoughts = nullptr;
+  for (auto &start : bucketStart) {
+    start = 0;
+  }
+  tickArena.Reset();
+  endPhase(TickPhase::REORDER);
+}
+
+void World::FireTimers(float deltaTime) {
+  // Only the timers' owners are touched. The wheel counts physics timesteps
+  // of simulated time, so sped-up ticks may advance it several slots at once.
+  simulationTime += deltaTime;
+  tickCount++;
+  firedTimers.clear();
+  timers.Advance((uint64_t)(simulationTime / Constants::PHYSICS_TIMESTEP),
+                 firedTimers);
+  for (const auto &event : firedTimers) {
+    Creature *creature = Find(event.creatureId);
+    if (creature && !creature->IsGhost()) {
+      creature->OnTimer(event, *this);
+    }
+  }
+}
+
+void World::SettleBirthsAndDeaths() {
+  // Admit this tick's children
+  for (size_t i = 0; i < births.size(); i++) {
+    Creature &child = births[i];
+    lineage.AddBirth(child.GetId(), birthParents[i].first,
+                     birthParents[i].second);
+    traitStats.Add(child.GetTraits());
+    if (brainsEnabled) {
+      brains.Add(birthGenomes[i]);
+    }
+    indexById[child.GetId()] = (uint32_t)creatures.size();
+    creatures.push_back(std::move(child));
+    creatureTimers.emplace_back();
+  }
+  births.clear();
+  birthGenomes.clear();
+  birthParents.clear();
+
+  // Remove consumed food
+  foods.erase(std::remove_if(foods.begin(), foods.end(),
+                             [](const Food &f) { return f.IsConsumed(); }),
+              foods.end());
+
+  // Remove dead creatures and release their lineages and statistics. The
+  // last creature fills each hole so only moved creatures are re-indexed.
+  for (size_t i = 0; i < creatures.size();) {
+    if (creatures[i].IsAlive() || creatures[i].IsGhost()) {
+      i++;
+      continue;
+    }
+    lineage.RecordDeath(creatures[i].GetId());
+    traitStats.Remove(creatures[i].GetTraits());
+    indexById.erase(creatures[i].GetId());
+    if (brainsEnabled) {
+      brains.Remove((uint32_t)i);
+    }
+
+    if (i + 1 < creatures.size()) {
+      creatures[i] = std::move(creatures.back());
+      creatureTimers[i] = creatureTimers.back();
+      indexById[creatures[i].GetId()] = (uint32_t)i;
+    }
+    creatures.pop_back();
+    creatureTimers.pop_back();
+  }
+}
@@ -0,0 +1,324 @@
+#include "world_gen.h"
+#include "constants.h"
+#include "names.h"
+#include "random_stream.h"
+#include "world.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+const size_t BLOCK = 4096; // Creatures or food per random stream
+const uint32_t NOT_KEPT = 0xFFFFFFFFu;
+
+// What a stream is drawn for, so that no two purposes share one
+enum Purpose : uint64_t {
+  CREATURE_POSITIONS,
+  CREATURE_TRAITS,
+  CREATURE_GENOMES,
+  FOOD_POSITIONS,
+  SUBSET = 0x80, // Added to a positions purpose for Poisson-disc subsets
+};
+
+// The stream for one block, or other unit, of one purpose
+RandomStream StreamFor(uint64_t seed, uint64_t purpose, uint64_t unit) {
+  RandomStream mixer(seed ^ (purpose << 56));
+  mixer.Next();
+  return RandomStream(mixer.Next() ^ (unit * 0xD6E8FEB86659FD93ull));
+}
+
+// Runs fn(unit, begin, end) over count items in units of unitSize, units
+// handed out to the threads as they come free
+template <typename Fn>
+void ParallelUnits(size_t count, size_t unitSize, int threads, Fn fn) {
+  const size_t units = (count + unitSize - 1) / unitSize;
+  std::atomic<size_t> next(0);
+  auto work = [&]() {
+    for (size_t unit; (unit = next++) < units;) {
+      fn(unit, unit * unitSize, std::min(count, (unit + 1) * unitSize));
+    }
+  };
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < std::min((size_t)threads, units); i++) {
+    helpers.emplace_back(work);
+  }
+  work();
+  for (auto &helper : helpers) {
+    helper.join();
+  }
+}
+
+// Inside the bounds, for the Gaussian tails of clusters
+Vector2 Confine(Vector2 point, const Rectangle &bounds) {
+  return Vector2{std::min(std::max(point.x, bounds.x), bounds.x + bounds.width),
+                 std::min(std::max(point.y, bounds.y),
+                          bounds.y + bounds.height)};
+}
+
+// Poisson-disc sampling on a grid of cells small enough to hold one point
+// each. Cells three apart in both directions cannot conflict, so the grid
+// is filled in nine passes of cells that are, each pass in parallel, with
+// every cell throwing a few darts against the passes before it. The spacing
+// is set so that more points fit than asked for, and a random subset is
+// kept: no two of those are closer than the spacing either.
+void PlacePoissonDisc(std::vector<Vector2> &points,
+                      const WorldGenConfig &config, int threads,
+                      uint64_t purpose) {
+  const Rectangle &bounds = config.bounds;
+  const size_t count = points.size();
+  const float area = std::max(bounds.width * bounds.height, 1.0f);
+  const float spacing = std::sqrt(0.55f * area / count);
+  const float cell = spacing / std::sqrt(2.0f);
+  const int columns = std::max((int)std::ceil(bounds.width / cell), 1);
+  const int rows = std::max((int)std::ceil(bounds.height / cell), 1);
+  const int DARTS = 8;
+
+  std::vector<Vector2> sample((size_t)columns * rows);
+  std::vector<uint8_t> filled(sample.size(), 0);
+  // Points in diagonal cells two away are at least the spacing apart, so
+  // those four are not checked
+  auto clear = [&](Vector2 point, int column, int row) {
+    for (int y = std::max(row - 2, 0); y <= std::min(row + 2, rows - 1); y++) {
+      for (int x = std::max(column - 2, 0);
+           x <= std::min(column + 2, columns - 1); x++) {
+        if (std::abs(x - column) == 2 && std::abs(y - row) == 2) {
+          continue;
+        }
+        size_t other = (size_t)y * columns + x;
+        float dx = sample[other].x - point.x;
+        float dy = sample[other].y - point.y;
+        if (filled[other] && dx * dx + dy * dy < spacing * spacing) {
+          return false;
+        }
+      }
+    }
+    return true;
+  };
+  for (int pass = 0; pass < 9; pass++) {
+    const int firstColumn = pass % 3;
+    const int firstRow = pass / 3;
+    const size_t passRows = (size_t)std::max((rows - firstRow + 2) / 3, 0);
+    ParallelUnits(passRows, 1, threads, [&](size_t, size_t begin, size_t) {
+      const int row = firstRow + 3 * (int)begin;
+      for (int column = firstColumn; column < columns; column += 3) {
+        const size_t index = (size_t)row * columns + column;
+        RandomStream stream = StreamFor(config.seed, purpose, index);
+        for (int dart = 0; dart < DARTS; dart++) {
+          Vector2 point = {
+              std::min(bounds.x + (column + stream.Uniform()) * cell,
+                       bounds.x + bounds.width),
+              std::min(bounds.y + (row + stream.Uniform()) * cell,
+                       bounds.y + bounds.height)};
+          if (clear(point, column, row)) {
+            sample[index] = point;
+            filled[index] = 1;
+            break;
+          }
+        }
+      }
+    });
+  }
+
+  // Keep the cells with the lowest random keys, in grid order so that
+  // neighbours stay close in storage
+  std::vector<std::pair<uint64_t, uint32_t>> kept;
+  for (size_t i = 0; i < sample.size(); i++) {
+    if (filled[i]) {
+      kept.emplace_back(StreamFor(config.seed, purpose + SUBSET, i).Next(),
+                        (uint32_t)i);
+    }
+  }
+  if (kept.size() > count) {
+    std::nth_element(kept.begin(), kept.begin() + count, kept.end());
+    kept.resize(count);
+  }
+  std::sort(kept.begin(), kept.end(),
+            [](const std::pair<uint64_t, uint32_t> &a,
+               const std::pair<uint64_t, uint32_t> &b) {
+              return a.second < b.second;
+            });
+  for (size_t i = 0; i < kept.size(); i++) {
+    points[i] = sample[kept[i].second];
+  }
+
+  // Not expected at this spacing; the rest go anywhere
+  if (kept.size() < count) {
+    TraceLog(LOG_WARNING, "WORLDGEN: Poisson disc fit %d of %d, rest uniform",
+             (int)kept.size(), (int)count);
+    RandomStream stream =
+        StreamFor(config.seed, purpose + SUBSET, sample.size());
+    for (size_t i = kept.size(); i < count; i++) {
+      points[i] = Vector2{bounds.x + stream.Uniform() * bounds.width,
+                          bounds.y + stream.Uniform() * bounds.height};
+    }
+  }
+}
+
+// Fills points with positions in the layout
+void Place(std::vector<Vector2> &points, Layout layout,
+           const WorldGenConfig &config, int threads, uint64_t purpose) {
+  const Rectangle &bounds = config.bounds;
+  if (points.empty()) {
+    return;
+  }
+  if (layout == Layout::POISSON_DISC) {
+    PlacePoissonDisc(points, config, threads, purpose);
+    return;
+  }
+
+  // Cluster centres come first, from a stream of their own
+  std::vector<Vector2> centres;
+  if (layout == Layout::CLUSTERED) {
+    RandomStream stream = StreamFor(config.seed, purpose, ~0ull);
+    for (int i = 0; i < std::max(config.clusters, 1); i++) {
+      centres.push_back(Vector2{bounds.x + stream.Uniform() * bounds.width,
+                                bounds.y + stream.Uniform() * bounds.height});
+    }
+  }
+  const float sigma =
+      config.clusterSpread * std::min(bounds.width, bounds.height);
+
+  ParallelUnits(points.size(), BLOCK, threads,
+                [&](size_t block, size_t begin, size_t end) {
+    RandomStream stream = StreamFor(config.seed, purpose, block);
+    for (size_t i = begin; i < end; i++) {
+      if (layout == Layout::UNIFORM) {
+        points[i] = Vector2{bounds.x + stream.Uniform() * bounds.width,
+                            bounds.y + stream.Uniform() * bounds.height};
+        continue;
+      }
+      // Box-Muller around a random centre
+      const Vector2 centre =
+          centres[stream.Range(0, (int)centres.size() - 1)];
+      float radius =
+          sigma * std::sqrt(-2.0f * std::log(1.0f - stream.Uniform()));
+      float angle = 2.0f * PI * stream.Uniform();
+      points[i] = Confine(Vector2{centre.x + radius * std::cos(angle),
+                                  centre.y + radius * std::sin(angle)},
+                          bounds);
+    }
+  });
+}
+} // namespace
+
+void WorldGen::Generate(World &world, const WorldGenConfig &config) {
+  const int threads =
+      config.threads > 0
+          ? config.threads
+          : (int)std::max(std::thread::hardware_concurrency(), 1u);
+
+  if (config.creatureCount > 0) {
+    const size_t count = (size_t)config.creatureCount;
+    std::vector<Vector2> positions(count);
+    Place(positions, config.creatureLayout, config, threads,
+          CREATURE_POSITIONS);
+
+    // Where each kept founder goes, counting from start; all of them
+    // unless the config keeps a subset
+    std::vector<uint32_t> slots;
+    size_t kept = count;
+    if (config.keep) {
+      slots.resize(count);
+      kept = 0;
+      for (size_t i = 0; i < count; i++) {
+        slots[i] = config.keep(positions[i]) ? (uint32_t)kept++ : NOT_KEPT;
+      }
+    }
+    auto slotOf = [&](size_t i) {
+      return slots.empty() ? (uint32_t)i : slots[i];
+    };
+
+    // Ids and names are handed out up front, so the index and the family
+    // tree can be filled on a thread of their own while the founders are
+    // built
+    const uint32_t firstId = Creature::TakeIds((uint32_t)count);
+    const Names::Reservation names = Names::Reserve(count);
+    const size_t start = world.creatures.size();
+    std::thread registrar([&]() {
+      world.indexById.reserve(world.indexById.size() + kept);
+      world.lineage.Reserve(kept);
+      for (size_t i = 0; i < count; i++) {
+        if (slotOf(i) != NOT_KEPT) {
+          world.indexById[firstId + (uint32_t)i] =
+              (uint32_t)(start + slotOf(i));
+          world.lineage.AddFounder(firstId + (uint32_t)i);
+        }
+      }
+    });
+
+    world.creatures.resize(start + kept, Creature::Blank());
+    world.creatureTimers.resize(start + kept);
+    if (world.brainsEnabled) {
+      world.brains.Resize((uint32_t)(start + kept));
+    }
+    ParallelUnits(count, BLOCK, threads,
+                  [&](size_t block, size_t begin, size_t end) {
+      // The same draws the Creature constructor makes
+      RandomStream stream = StreamFor(config.seed, CREATURE_TRAITS, block);
+      for (size_t i = begin; i < end; i++) {
+        bool isMale = stream.Range(0, 1) == 1;
+        float strength = (float)stream.Range((int)Constants::MIN_STRENGTH,
+                                             (int)Constants::MAX_STRENGTH);
+        float speed = stream.Range((int)(Constants::MIN_SPEED * 100),
+                                   (int)(Constants::MAX_SPEED * 100)) /
+                      100.0f;
+        float metabolism =
+            stream.Range((int)(Constants::MIN_METABOLISM * 100),
+                         (int)(Constants::MAX_METABOLISM * 100)) /
+            100.0f;
+        const uint32_t slot = slotOf(i);
+        if (slot == NOT_KEPT) {
+          continue;
+        }
+        world.creatures[start + slot] = Creature::Founder(
+            firstId + (uint32_t)i, names.Code(i), positions[i],
+            Constants::INITIAL_CREATURE_SIZE, isMale, strength, speed,
+            metabolism);
+        // Brains come from a stream of their own, so that worlds with and
+        // without them start with the same founders
+        if (world.brainsEnabled) {
+          RandomStream weights =
+              StreamFor(config.seed, CREATURE_GENOMES, start + i);
+          Genome genome;
+          for (float &weight : genome.weights) {
+            weight = weights.Range(-1000, 1000) / 1000.0f;
+          }
+          world.brains.Set((uint32_t)(start + slot), genome);
+        }
+      }
+    });
+    for (size_t i = start; i < start + kept; i++) {
+      world.traitStats.Add(world.creatures[i].GetTraits());
+    }
+    registrar.join();
+  }
+
+  if (config.foodCount > 0) {
+    const size_t count = (size_t)config.foodCount;
+    std::vector<Vector2> positions(count);
+    Place(positions, config.foodLayout, config, threads, FOOD_POSITIONS);
+    world.foods.reserve(world.foods.size() + count);
+    for (const Vector2 &position : positions) {
+      if (!config.keep || config.keep(position)) {
+        world.foods.emplace_back(position);
+      }
+    }
+  }
+}
+
+bool WorldGen::ParseLayout(const char *name, Layout &layout) {
+  if (strcmp(name, "uniform") == 0) {
+    layout = Layout::UNIFORM;
+  } else if (strcmp(name, "clustered") == 0) {
+    layout = Layout::CLUSTERED;
+  } else if (strcmp(name, "poisson") == 0) {
+    layout = Layout::POISSON_DISC;
+  } else {
+    return false;
+  }
+  return true;
+}